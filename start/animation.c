@@ -0,0 +1,198 @@
+// Display animations run by the board itself
+//
+#include "animation.h"
+
+#include "display.h"
+
+/// Segments round the outside of the digit, clockwise from the top
+static const uint8_t chase_segments[] = {
+    SEGMENT_E_BIT,
+    SEGMENT_G_BIT,
+    SEGMENT_F_BIT,
+    SEGMENT_A_BIT,
+    SEGMENT_B_BIT,
+    SEGMENT_C_BIT,
+};
+
+static struct timer_task step_task;
+
+// Set up by the animation_x() functions, and moved along by step_task
+static volatile enum animation_effect effect = ANIMATION_NONE;
+static uint8_t from;
+static uint8_t to;
+
+/// Steps taken so far
+static uint16_t step;
+
+/// Steps to take before finishing, 0 to go on for ever
+static uint16_t steps;
+
+/// Brightness for a step of the fade
+///
+/// The eye sees brightness as roughly the square root of the duty cycle, so
+/// the duty cycle follows a square from the dark end for an even looking fade.
+static uint8_t fade_level(void)
+{
+    const uint16_t full = ANIMATION_FADE_STEPS * ANIMATION_FADE_STEPS;
+
+    if (to > from) {
+        return from + (uint32_t)(to - from) * step * step / full;
+    }
+
+    uint16_t left = ANIMATION_FADE_STEPS - step;
+    return to + (uint32_t)(from - to) * left * left / full;
+}
+
+/// Shows the effect as it is after step steps
+static void show_step(void)
+{
+    switch (effect) {
+        case ANIMATION_FADE:
+            display_set_brightness(fade_level());
+            break;
+
+        case ANIMATION_FLASH:
+            // Dark on odd steps, so even ones end lit
+            display_set_hidden(step & 1);
+            break;
+
+        case ANIMATION_ROLL:
+            show_digit((from + step) % 10);
+            break;
+
+        case ANIMATION_CHASE:
+            display_set_overlay(chase_segments[step % ARRAY_SIZE(chase_segments)]);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/// Leaves the display as the effect ends, and forgets about it
+static void finish(void)
+{
+    switch (effect) {
+        case ANIMATION_FADE:
+            display_set_brightness(to);
+            break;
+
+        case ANIMATION_FLASH:
+            display_set_hidden(false);
+            break;
+
+        case ANIMATION_ROLL:
+            show_digit(to);
+            break;
+
+        case ANIMATION_CHASE:
+            display_clear_overlay();
+            break;
+
+        default:
+            break;
+    }
+
+    effect = ANIMATION_NONE;
+}
+
+static void step_task_cb(const struct timer_task *const timer_task)
+{
+    ++step;
+
+    if (steps && step >= steps) {
+        timer_remove_task(&TIMER_0, &step_task);
+        finish();
+    } else {
+        show_step();
+    }
+}
+
+void animation_stop(void)
+{
+    CRITICAL_SECTION_ENTER()
+    if (effect != ANIMATION_NONE) {
+        timer_remove_task(&TIMER_0, &step_task);
+        finish();
+    }
+    CRITICAL_SECTION_LEAVE()
+}
+
+/// Replaces whatever's running with a new effect, set up in from, to, step
+/// and steps, and shows its first step
+static void start(enum animation_effect new_effect, uint16_t step_ms)
+{
+    effect = new_effect;
+
+    if (!step_ms) {
+        finish();
+        return;
+    }
+
+    show_step();
+
+    // TIMER_0 ticks every millisecond
+    step_task.interval = step_ms;
+    step_task.cb = step_task_cb;
+    step_task.mode = TIMER_TASK_REPEAT;
+    timer_add_task(&TIMER_0, &step_task);
+}
+
+void animation_fade(uint16_t step_ms, uint8_t from_level, uint8_t to_level)
+{
+    animation_stop();
+
+    CRITICAL_SECTION_ENTER()
+    from = from_level;
+    to = to_level;
+    step = 0;
+    steps = ANIMATION_FADE_STEPS;
+    start(ANIMATION_FADE, step_ms);
+    CRITICAL_SECTION_LEAVE()
+}
+
+void animation_flash(uint16_t step_ms, uint8_t count)
+{
+    animation_stop();
+
+    CRITICAL_SECTION_ENTER()
+    // The step counting starts from the first blank, which is step 1
+    step = 1;
+    steps = 2 * count;
+    start(ANIMATION_FLASH, step_ms);
+    CRITICAL_SECTION_LEAVE()
+}
+
+void animation_roll(uint16_t step_ms, uint8_t from_digit, uint8_t to_digit)
+{
+    animation_stop();
+
+    CRITICAL_SECTION_ENTER()
+    from = from_digit <= 9 ? from_digit : 0;
+    to = to_digit;
+    step = 0;
+    steps = (to_digit + 10 - from) % 10;
+
+    // Nothing to roll through, so just show it
+    if (to_digit > 9 || !steps) {
+        step_ms = 0;
+    }
+    start(ANIMATION_ROLL, step_ms);
+    CRITICAL_SECTION_LEAVE()
+}
+
+void animation_chase(uint16_t step_ms, uint8_t laps)
+{
+    animation_stop();
+
+    CRITICAL_SECTION_ENTER()
+    step = 0;
+    steps = laps * ARRAY_SIZE(chase_segments);
+    start(ANIMATION_CHASE, step_ms);
+    CRITICAL_SECTION_LEAVE()
+}
+
+enum animation_effect animation_get_effect(void)
+{
+    return effect;
+}
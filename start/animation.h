@@ -0,0 +1,51 @@
+// Display animations run by the board itself
+//
+// Rolling a digit up or flashing it used to take a transaction from the
+// master for every step.  Now the master starts an effect once, and a TIMER_0
+// task steps it along, so the bus stays quiet while the board animates.
+//
+// Only one effect runs at a time, and starting one stops whatever was running.
+// A step period of 0 skips straight to where the effect would end.
+//
+#ifndef ANIMATION_H_INCLUDED
+#define ANIMATION_H_INCLUDED
+
+#include <atmel_start.h>
+
+enum animation_effect {
+    ANIMATION_NONE,
+    ANIMATION_FADE,
+    ANIMATION_FLASH,
+    ANIMATION_ROLL,
+    ANIMATION_CHASE,
+};
+
+/// Steps in a fade, whatever its length
+#define ANIMATION_FADE_STEPS 16
+
+/// Fades the brightness from one level to another, in ANIMATION_FADE_STEPS
+/// steps of step_ms milliseconds
+void animation_fade(uint16_t step_ms, uint8_t from, uint8_t to);
+
+/// Blanks the display count times, for step_ms milliseconds each time with
+/// step_ms between them.  0 keeps flashing until stopped.
+void animation_flash(uint16_t step_ms, uint8_t count);
+
+/// Counts the digit shown up from one digit to another, wrapping from 9 to 0,
+/// a digit every step_ms milliseconds.  Starting from a blank display counts
+/// from 0, and rolling to anything but a digit just blanks the display.
+void animation_roll(uint16_t step_ms, uint8_t from, uint8_t to);
+
+/// Runs a single lit segment clockwise round the outside of the digit, a
+/// segment every step_ms milliseconds, for laps times round.  0 keeps going
+/// until stopped.  The digit underneath comes back afterwards.
+void animation_chase(uint16_t step_ms, uint8_t laps);
+
+/// Stops the running effect, leaving the display as if it had finished.  A
+/// flash or chase that would go on for ever leaves it as it was to start with.
+void animation_stop(void);
+
+/// The effect that's running, ANIMATION_NONE if none is
+enum animation_effect animation_get_effect(void);
+
+#endif // ANIMATION_H_INCLUDED
@@ -0,0 +1,65 @@
+// Cycle counting benchmarks of the I2C to segment path
+//
+#include "bench.h"
+
+#include <hal_atomic.h>
+
+volatile struct bench_stats bench_stats;
+
+void bench_init(void)
+{
+    SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+    SysTick->VAL = 0;
+    SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+
+    bench_reset();
+}
+
+void bench_reset(void)
+{
+    CRITICAL_SECTION_ENTER()
+    bench_stats.version = BENCH_STATS_VERSION;
+    bench_stats.probe_count = BENCH_PROBE_COUNT;
+    bench_stats.busy_cycles_per_second = 0;
+    bench_stats.rx_nacks = 0;
+    bench_stats.rx_holds = 0;
+    bench_stats.rx_frames_dropped = 0;
+
+    for (uint8_t i = 0; i < BENCH_PROBE_COUNT; ++i) {
+        bench_stats.probes[i].count = 0;
+        bench_stats.probes[i].last = 0;
+        bench_stats.probes[i].min = UINT32_MAX;
+        bench_stats.probes[i].max = 0;
+        bench_stats.probes[i].total = 0;
+    }
+
+    // What a probe around nothing at all measures
+    const uint32_t start = cycle_counter_read();
+    bench_stats.overhead = cycles_since(start);
+    CRITICAL_SECTION_LEAVE()
+}
+
+void bench_record(enum bench_probe probe, uint32_t cycles)
+{
+    volatile struct bench_probe_stats *stats = &bench_stats.probes[probe];
+
+    // Some probes are recorded from both the main loop and interrupts, eg
+    // show_digit() from a frame and from an animation step, so an interrupt
+    // mustn't land in the middle of an update
+    CRITICAL_SECTION_ENTER()
+    ++stats->count;
+    stats->last = cycles;
+    stats->total += cycles;
+    if (cycles < stats->min) {
+        stats->min = cycles;
+    }
+    if (cycles > stats->max) {
+        stats->max = cycles;
+    }
+    CRITICAL_SECTION_LEAVE()
+}
+
+void bench_record_hook(uint8_t probe, uint32_t cycles)
+{
+    bench_record((enum bench_probe)probe, cycles);
+}
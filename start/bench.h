@@ -0,0 +1,99 @@
+// Cycle counting benchmarks of the I2C to segment path
+//
+// The Cortex-M0+ has no DWT cycle counter, so SysTick free-runs as one
+// instead.  It's set up through the CMSIS SysTick struct, because
+// hri_systick_d10.h is empty unless the device headers define a SysTick
+// component, which the SAMD10 ones don't.
+//
+// Each probe keeps its stats in bench_stats, which sits at a fixed symbol in
+// RAM so it can be read with the debugger (eg `print bench_stats` in gdb) and
+// compared between firmware versions.  Build with -DBENCH_ENABLED=0, or untick
+// it in config/isr_hooks_config.h, to leave out the probes.  The drivers'
+// probes are that file's CONF_ISR_BENCH_BEGIN()/CONF_ISR_BENCH_END() hooks, so
+// they don't include this.
+//
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+#include <compiler.h>
+#include <isr_hooks_config.h>
+
+/// Things that are timed
+enum bench_probe {
+    BENCH_SERCOM0_HANDLER = CONF_BENCH_PROBE_SERCOM0_HANDLER, // Whole I2C slave interrupt
+    BENCH_TC1_HANDLER = CONF_BENCH_PROBE_TC1_HANDLER,         // Whole TIMER_0 interrupt
+    BENCH_TIMER_PROCESS = CONF_BENCH_PROBE_TIMER_PROCESS,     // timer_process_counted(), inside TC1_Handler
+    BENCH_SHOW_DIGIT,                                         // show_digit()
+    BENCH_DISPATCH,                                           // Main loop reading and handling received frames
+    BENCH_STOP_TO_DISPLAY,                                    // I2C stop condition to the end of the dispatch
+    BENCH_PROBE_COUNT
+};
+
+/// Timings of one probe, all in CPU cycles
+struct bench_probe_stats {
+    uint32_t count;
+    uint32_t last;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total; // Wraps after ~9 minutes of busy CPU at 8MHz, or 90s at 48MHz, use deltas
+};
+
+/// Bumped whenever the layout of struct bench_stats changes
+#define BENCH_STATS_VERSION 2
+
+struct bench_stats {
+    uint8_t version;
+    uint8_t probe_count;
+    uint16_t overhead;  // Cycles a probe adds to what it measures
+    uint32_t busy_cycles_per_second; // CPU cycles spent awake in the last second
+
+    // I2C_0 receive overflows since reset, latched along with the load
+    uint32_t rx_nacks;          // Writes cut short with a NACK, for want of buffer space, once each
+    uint32_t rx_holds;          // Times SCL was held low, waiting for buffer space
+    uint32_t rx_frames_dropped; // Whole frames lost, for want of buffer space
+
+    struct bench_probe_stats probes[BENCH_PROBE_COUNT];
+};
+
+extern volatile struct bench_stats bench_stats;
+
+/// Starts SysTick free-running over its full 24 bits, without an interrupt,
+/// and clears the stats
+///
+/// SysTick counts down at the CPU clock, so the cycle counter is good for
+/// timing things that take less than 2 seconds at 8MHz, or a third of a
+/// second while the CPU is boosted to 48MHz (see clock_profile.h).
+void bench_init(void);
+
+/// Clears the stats, eg before a run that's going to be compared
+void bench_reset(void);
+
+/// Adds a measurement to a probe's stats
+void bench_record(enum bench_probe probe, uint32_t cycles);
+
+static inline uint32_t cycle_counter_read(void)
+{
+    return SysTick->VAL;
+}
+
+/// CPU cycles since the cycle counter read start
+static inline uint32_t cycles_since(uint32_t start)
+{
+    return (start - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk;
+}
+
+#if BENCH_ENABLED
+
+/// Times from here to the matching BENCH_END() in the same block.  Any
+/// interrupts taken in between are counted too.
+#define BENCH_BEGIN(probe) const uint32_t bench_start_##probe = cycle_counter_read()
+#define BENCH_END(probe) bench_record(probe, cycles_since(bench_start_##probe))
+
+#else
+
+#define BENCH_BEGIN(probe) do {} while (0)
+#define BENCH_END(probe) do {} while (0)
+
+#endif // BENCH_ENABLED
+
+#endif // BENCH_H_INCLUDED
@@ -0,0 +1,54 @@
+// Timekeeping calibration against the master's clock
+//
+#include "calibration.h"
+
+/// A rate of 1.0, in the 16.16 fixed point the rates are kept in
+#define RATE_ONE (1UL << 16)
+
+/// Milliseconds per TIMER_0 tick, and the other way up
+static uint32_t ms_per_tick = RATE_ONE;
+static uint32_t ticks_per_ms = RATE_ONE;
+
+/// Measurements in the average, up to CALIBRATION_AVERAGE
+static uint8_t samples = 0;
+
+/// When the last CALIBRATE frame arrived, if there's been one
+static uint32_t last_ticks;
+static bool synced = false;
+
+void calibration_sync(uint16_t interval_ms)
+{
+    uint32_t now = timer_get_ticks(&TIMER_0);
+    uint32_t measured = now - last_ticks;
+    bool valid = synced && interval_ms;
+
+    last_ticks = now;
+    synced = true;
+
+    if (!valid ||
+        measured < interval_ms - interval_ms / CALIBRATION_MAX_ERROR ||
+        measured > interval_ms + interval_ms / CALIBRATION_MAX_ERROR) {
+        return;
+    }
+
+    // Fits, as interval_ms is 16 bits
+    uint32_t rate = ((uint32_t)interval_ms << 16) / measured;
+
+    if (samples < CALIBRATION_AVERAGE) {
+        ++samples;
+    }
+    ms_per_tick += ((int32_t)rate - (int32_t)ms_per_tick) / samples;
+
+    // Near enough 2^32 / ms_per_tick, as a 32 bit division
+    ticks_per_ms = UINT32_MAX / ms_per_tick;
+}
+
+uint64_t calibration_ticks_to_ms(uint32_t ticks)
+{
+    return (uint64_t)ticks * ms_per_tick;
+}
+
+uint32_t calibration_ms_to_ticks(uint32_t ms)
+{
+    return ((uint64_t)ms * ticks_per_ms + RATE_ONE - 1) >> 16;
+}
@@ -0,0 +1,42 @@
+// Timekeeping calibration against the master's clock
+//
+// OSC8M is only good to a few percent, which puts a clock counted by one
+// board seconds a minute out from the next.  The master broadcasts a
+// CALIBRATE frame at a steady interval, saying how long it's been since the
+// last one by its own clock.  Each board times the same interval on TIMER_0,
+// and the difference is how far off its OSC8M is.
+//
+// The correction is done in software, by scaling TIMER_0 ticks to
+// milliseconds, rather than by trimming OSC8M.  That way it's as fine as the
+// measurements are, and OSC8M keeps its factory calibration.
+//
+// A tick is measured to a millisecond, so the longer the interval the better
+// the measurement: 1s between frames gets each one to within 0.1%, and
+// averaging a few takes it well under that.
+//
+#ifndef CALIBRATION_H_INCLUDED
+#define CALIBRATION_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// Measurements further off than this from the interval they're meant to be
+/// are taken to be a missed or delayed frame, and ignored.  As a fraction, 1/x.
+#define CALIBRATION_MAX_ERROR 16
+
+/// The first measurements are averaged, and after that each new one only
+/// counts for 1/x, to smooth over when frames arrive
+#define CALIBRATION_AVERAGE 8
+
+/// Notes when a CALIBRATE frame arrived, and updates the correction from how
+/// long it was since the last one by TIMER_0, against interval_ms by the
+/// master's clock.  An interval of 0 just notes the time, eg for the first.
+void calibration_sync(uint16_t interval_ms);
+
+/// Milliseconds by the master's clock in a number of TIMER_0 ticks, in 16.16
+/// fixed point so that times added up from several pieces don't lose any
+uint64_t calibration_ticks_to_ms(uint32_t ticks);
+
+/// TIMER_0 ticks in a number of milliseconds by the master's clock, rounded up
+uint32_t calibration_ms_to_ticks(uint32_t ms);
+
+#endif // CALIBRATION_H_INCLUDED
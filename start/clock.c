@@ -0,0 +1,224 @@
+// Shot clock and game clock, counted by each digit board itself
+//
+#include "clock.h"
+
+#include "calibration.h"
+#include "display.h"
+
+/// Turns a time in tenths into the digit at a place
+struct clock_place_digit {
+    uint16_t tenths;  // Tenths of a second in a unit of the place
+    uint8_t  modulus; // Units before the place wraps round to 0
+};
+
+static const struct clock_place_digit place_digits[CLOCK_PLACE_COUNT] = {
+    [CLOCK_PLACE_TENTHS]      = {1, 10},
+    [CLOCK_PLACE_SECONDS]     = {10, 10},
+    [CLOCK_PLACE_TEN_SECONDS] = {100, 6},
+    [CLOCK_PLACE_MINUTES]     = {600, 10},
+    [CLOCK_PLACE_TEN_MINUTES] = {6000, 10},
+    [CLOCK_PLACE_TENS]        = {100, 10},
+    [CLOCK_PLACE_HUNDREDS]    = {1000, 10},
+};
+
+static enum clock_mode mode = CLOCK_OFF;
+static uint8_t place = CLOCK_PLACE_TENTHS;
+static bool running = false;
+
+/// Time in milliseconds at start_ticks while running, or just the time if not
+static uint32_t base_ms = 0;
+static uint32_t start_ticks;
+
+/// Part of a millisecond that had passed but wasn't counted in base_ms, in
+/// 1/65536ths, so the time doesn't lose any each time it's rebased
+static uint16_t base_fraction = 0;
+
+/// Wakes us up when the digit at our place next changes
+static struct timer_task update_task;
+static bool updating = false;
+
+static const struct clock_place_digit *place_digit(void)
+{
+    return &place_digits[place & ~CLOCK_PLACE_BLANK_ZERO];
+}
+
+/// Milliseconds counted since base_ms, in 16.16 fixed point
+static uint64_t elapsed_ms(uint32_t now)
+{
+    return calibration_ticks_to_ms(now - start_ticks) + base_fraction;
+}
+
+/// The time after counting ms milliseconds on from base_ms
+static uint32_t counted(uint32_t ms)
+{
+    if (mode == CLOCK_DOWN) {
+        return ms < base_ms ? base_ms - ms : 0;
+    }
+    return base_ms + ms;
+}
+
+/// The time now, in milliseconds
+static uint32_t clock_ms(void)
+{
+    if (!running) {
+        return base_ms;
+    }
+
+    return counted(elapsed_ms(timer_get_ticks(&TIMER_0)) >> 16);
+}
+
+/// Tenths of a second shown for a time
+///
+/// Counting down rounds up, so 0 isn't shown until the time is up.
+static uint32_t shown_tenths(uint32_t ms)
+{
+    return mode == CLOCK_DOWN ? (ms + 99) / 100 : ms / 100;
+}
+
+/// Milliseconds from ms until the digit at our place changes, 0 for never
+static uint32_t ms_to_change(uint32_t ms)
+{
+    uint32_t unit_ms = place_digit()->tenths * 100UL;
+
+    if (mode == CLOCK_DOWN) {
+        uint32_t units = shown_tenths(ms) / place_digit()->tenths;
+
+        // Changes when the shown tenths drop below a whole unit, or otherwise
+        // when the time's up
+        return units ? ms - (units * unit_ms - 100) : ms;
+    }
+
+    return (ms / unit_ms + 1) * unit_ms - ms;
+}
+
+static void show(uint32_t ms)
+{
+    uint32_t units = shown_tenths(ms) / place_digit()->tenths;
+
+    if (!units && (place & CLOCK_PLACE_BLANK_ZERO)) {
+        show_digit(UINT8_MAX); // Blanks
+    } else {
+        show_digit(units % place_digit()->modulus);
+    }
+}
+
+/// Restarts the running time from now, so how it's counted can change
+static void rebase(void)
+{
+    uint32_t now = timer_get_ticks(&TIMER_0);
+
+    if (running) {
+        uint64_t elapsed = elapsed_ms(now);
+
+        base_ms = counted(elapsed >> 16);
+        base_fraction = elapsed & 0xFFFF;
+    }
+    start_ticks = now;
+}
+
+static void update_task_cb(const struct timer_task *const timer_task);
+
+/// Shows the time now, and sets update_task for when that changes.  Call with
+/// interrupts masked.
+static void update(void)
+{
+    if (updating) {
+        timer_remove_task(&TIMER_0, &update_task);
+        updating = false;
+    }
+
+    if (mode == CLOCK_OFF) {
+        return;
+    }
+
+    uint32_t ms = clock_ms();
+    show(ms);
+
+    if (!running) {
+        return;
+    }
+
+    uint32_t wait = ms_to_change(ms);
+    if (!wait) {
+        // The countdown has finished
+        running = false;
+        base_ms = 0;
+        return;
+    }
+
+    update_task.interval = calibration_ms_to_ticks(wait);
+    update_task.cb = update_task_cb;
+    update_task.mode = TIMER_TASK_ONE_SHOT;
+    timer_add_task(&TIMER_0, &update_task);
+    updating = true;
+}
+
+static void update_task_cb(const struct timer_task *const timer_task)
+{
+    // One shot tasks are off the queue by the time they run
+    updating = false;
+    update();
+}
+
+void clock_set_mode(enum clock_mode new_mode)
+{
+    CRITICAL_SECTION_ENTER()
+    rebase();
+    mode = new_mode;
+    if (mode == CLOCK_OFF) {
+        running = false;
+    }
+    update();
+    CRITICAL_SECTION_LEAVE()
+}
+
+void clock_set_place(uint8_t new_place)
+{
+    if ((new_place & ~CLOCK_PLACE_BLANK_ZERO) >= CLOCK_PLACE_COUNT) {
+        return;
+    }
+
+    CRITICAL_SECTION_ENTER()
+    place = new_place;
+    update();
+    CRITICAL_SECTION_LEAVE()
+}
+
+void clock_sync(uint32_t tenths)
+{
+    CRITICAL_SECTION_ENTER()
+    base_ms = tenths * 100;
+    base_fraction = 0;
+    start_ticks = timer_get_ticks(&TIMER_0);
+    update();
+    CRITICAL_SECTION_LEAVE()
+}
+
+void clock_start(void)
+{
+    CRITICAL_SECTION_ENTER()
+    if (mode != CLOCK_OFF && !running) {
+        rebase();
+        running = true;
+        update();
+    }
+    CRITICAL_SECTION_LEAVE()
+}
+
+void clock_stop(void)
+{
+    CRITICAL_SECTION_ENTER()
+    rebase();
+    running = false;
+    update();
+    CRITICAL_SECTION_LEAVE()
+}
+
+void clock_calibrate(uint16_t interval_ms)
+{
+    CRITICAL_SECTION_ENTER()
+    rebase();
+    calibration_sync(interval_ms);
+    update();
+    CRITICAL_SECTION_LEAVE()
+}
@@ -0,0 +1,64 @@
+// Shot clock and game clock, counted by each digit board itself
+//
+// Rather than the master sending new digits every tenth of a second, every
+// board of a clock counts the same time from its own TIMER_0, and shows the
+// one digit of it at its place.  The master sets each board's place and
+// direction, then sets the time, starts and stops all the boards at once with
+// broadcasts.
+//
+// A board only wakes when its own digit changes, so the tenths board wakes
+// ten times a second but the minutes board once a minute.
+//
+// Each board's clock is only as good as OSC8M, which is a few percent out,
+// so the boards drift apart unless they're calibrated - see calibration.h.
+// Even then, syncing to the master's time now and then, eg at each stoppage,
+// keeps them together.
+//
+#ifndef CLOCK_H_INCLUDED
+#define CLOCK_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// Which digit of the time a board shows
+enum clock_place {
+    CLOCK_PLACE_TENTHS,       // Tenths of a second
+    CLOCK_PLACE_SECONDS,      // Units of seconds
+    CLOCK_PLACE_TEN_SECONDS,  // Tens of seconds, of minutes and seconds, 0-5
+    CLOCK_PLACE_MINUTES,      // Units of minutes
+    CLOCK_PLACE_TEN_MINUTES,  // Tens of minutes
+    CLOCK_PLACE_TENS,         // Tens of seconds, of seconds alone, 0-9
+    CLOCK_PLACE_HUNDREDS,     // Hundreds of seconds, of seconds alone
+    CLOCK_PLACE_COUNT
+};
+
+/// Or'd with a clock_place, blanks the digit rather than show a leading 0
+#define CLOCK_PLACE_BLANK_ZERO 0x80
+
+enum clock_mode {
+    CLOCK_OFF,  // Leaves the display to show_digit() and friends
+    CLOCK_UP,   // Stopwatch
+    CLOCK_DOWN, // Countdown, stopping at 0
+};
+
+/// Sets which way the clock counts, or turns it off.  The time carries on
+/// from where it is.
+void clock_set_mode(enum clock_mode mode);
+
+/// Sets which digit of the time to show, a clock_place perhaps with
+/// CLOCK_PLACE_BLANK_ZERO
+void clock_set_place(uint8_t place);
+
+/// Sets the time, in tenths of a second, from now.  Doesn't start or stop it.
+void clock_sync(uint32_t tenths);
+
+/// Starts the clock counting from the time it shows, unless it's off
+void clock_start(void);
+
+/// Stops the clock where it is, to the millisecond
+void clock_stop(void);
+
+/// Handles a CALIBRATE frame, see calibration_sync().  The time so far is
+/// kept as it was counted, and the new calibration counts from now.
+void clock_calibrate(uint16_t interval_ms);
+
+#endif // CLOCK_H_INCLUDED
@@ -0,0 +1,73 @@
+// CPU clock profiles, switching GCLK0 between OSC8M and the DFLL
+//
+#include "clock_profile.h"
+
+#include <atmel_start.h>
+#include <hpl_gclk_base.h>
+#include <hpl_gclk_config.h>
+#include <hpl_pm_config.h>
+#include <hpl_sercom_config.h>
+
+void clock_profile_init(void)
+{
+#if CONF_SERCOM_0_I2CS_SPEED
+    // GCLK2 is otherwise unused.  It runs in standby, so SERCOM0 still sees
+    // an address match there, and keeps the DFLL running with it.
+    hri_gclk_write_GENDIV_reg(GCLK, GCLK_GENDIV_DIV(1) | GCLK_GENDIV_ID(2));
+    hri_gclk_write_GENCTRL_reg(GCLK,
+                               GCLK_GENCTRL_RUNSTDBY | GCLK_GENCTRL_GENEN | GCLK_GENCTRL_SRC_DFLL48M
+                                   | GCLK_GENCTRL_ID(2));
+    hri_gclk_wait_for_sync(GCLK);
+
+    // A channel's generator can only change while it's disabled.  Writing
+    // just the ID byte selects the channel for reading back, and CLKEN stays
+    // set until the channel has stopped.
+    hri_gclk_write_CLKCTRL_reg(GCLK, GCLK_CLKCTRL_ID(SERCOM0_GCLK_ID_CORE));
+    do {
+        *(volatile uint8_t *)&GCLK->CLKCTRL.reg = GCLK_CLKCTRL_ID(SERCOM0_GCLK_ID_CORE);
+    } while (hri_gclk_get_CLKCTRL_CLKEN_bit(GCLK));
+
+    _gclk_enable_channel(SERCOM0_GCLK_ID_CORE, GCLK_CLKCTRL_GEN_GCLK2_Val);
+#endif
+}
+
+#if CLOCK_PROFILES_ENABLED
+
+/// GENCTRL for GCLK0, less its source
+#define GCLK0_GENCTRL                                                                                                  \
+    ((CONF_GCLK_GEN_0_RUNSTDBY << GCLK_GENCTRL_RUNSTDBY_Pos) | (CONF_GCLK_GEN_0_IDC << GCLK_GENCTRL_IDC_Pos)           \
+     | GCLK_GENCTRL_GENEN | GCLK_GENCTRL_ID(0))
+
+static bool boosted = false;
+
+void clock_profile_boost(void)
+{
+    if (boosted) {
+        return;
+    }
+    boosted = true;
+
+    // Flash has to be slowed down before the CPU speeds up
+    hri_nvmctrl_write_CTRLB_RWS_bf(NVMCTRL, CLOCK_PROFILE_BOOST_WAIT_STATES);
+
+    // GCLK0 asks the DFLL to start, and keeps running from OSC8M until it has
+    hri_gclk_write_GENCTRL_reg(GCLK, GCLK0_GENCTRL | GCLK_GENCTRL_SRC_DFLL48M);
+}
+
+void clock_profile_low(void)
+{
+    if (!boosted) {
+        return;
+    }
+    boosted = false;
+
+    // This waits out any boost still going, the bus stalling until GCLK is
+    // ready for another write
+    hri_gclk_write_GENCTRL_reg(GCLK, GCLK0_GENCTRL | CONF_GCLK_GEN_0_SRC);
+
+    // Flash keeps its wait state until the CPU is back on OSC8M
+    hri_gclk_wait_for_sync(GCLK);
+    hri_nvmctrl_write_CTRLB_RWS_bf(NVMCTRL, CONF_NVM_WAIT_STATE);
+}
+
+#endif // CLOCK_PROFILES_ENABLED
@@ -0,0 +1,87 @@
+// CPU clock profiles, switching GCLK0 between OSC8M and the DFLL
+//
+// The CPU idles at 8MHz from OSC8M, and boosts to 48MHz from the DFLL while
+// there's work for the main loop: from an I2C address match on the DMA path,
+// and from each received frame.  The once a second telemetry refresh is a
+// few hundred cycles of copying, less than the DFLL's start-up would cost,
+// so it runs at 8MHz.  wait_for_event() drops back to OSC8M just before
+// sleeping.  TC1, TCC0 and
+// SERCOM0 run from OSC8M through GCLK1, so the millisecond tick, the PWM and
+// the I2C slave don't notice the CPU clock changing under them.
+//
+// The DFLL runs open loop from its factory calibration, on demand, so it
+// only runs while GCLK0 asks for it, which it doesn't in standby.  Its
+// start-up is a few microseconds, which the boost doesn't wait for: GCLK0
+// carries on from OSC8M until the DFLL is ready, then switches without a
+// glitch.  From an address match that's hidden behind the bytes still to
+// come.
+//
+// The trade-off, for a board on a 3.3V supply:
+//  - Flash needs a wait state above 24MHz, which boosting adds and dropping
+//    takes away again.  Code run while boosted pays for it, mostly the
+//    main loop, as the interrupt handlers mostly run at 8MHz with none.
+//    Build with -DRAMFUNC_ENABLED=1 to run the handlers on the I2C to display
+//    path from SRAM instead (see ramfunc.h), at the cost of some SRAM.
+//  - The DFLL takes a few hundred uA on top of the CPU while it runs, but
+//    a CPU at 48MHz takes less charge per cycle than at 8MHz, because the
+//    parts of the chip that run regardless are shared over six times as many
+//    cycles.  The main loop's work is short and bursty, so finishing it six
+//    times sooner and getting back to standby saves more than the DFLL
+//    costs.  Standby current is unchanged, as the DFLL is stopped by then.
+//  - The time from a stop condition to the display changing is set by the
+//    main loop, so it's up to six times shorter, less the DFLL start-up.
+//    The interrupt handlers mostly run at 8MHz, as before.
+//
+// Above Fast-mode (CONF_SERCOM_0_I2CS_SPEED in hpl_sercom_config.h), SCL's
+// high time is down to 260ns at 1MHz, or 60ns in High-speed mode, too short
+// for SERCOM0 to sample at 8MHz.  clock_profile_init() then gives SERCOM0 a
+// 48MHz core clock from the DFLL through GCLK2, and SERCOM0 keeps the DFLL
+// running in standby to wake on an address match - a few hundred uA more in
+// standby, which is the price of the faster bus.
+//
+// bench_stats counts CPU cycles, which are six times shorter while boosted,
+// so compare its figures from builds with the same profiles.  Build with
+// -DCLOCK_PROFILES_ENABLED=0 to stay at 8MHz.
+//
+#ifndef CLOCK_PROFILE_H_INCLUDED
+#define CLOCK_PROFILE_H_INCLUDED
+
+#include <compiler.h>
+
+#ifndef CLOCK_PROFILES_ENABLED
+#define CLOCK_PROFILES_ENABLED 1
+#endif
+
+/// CPU clock while boosted, from the DFLL undivided
+#define CLOCK_PROFILE_BOOST_HZ 48000000
+
+/// Flash wait states while boosted, enough up to 48MHz from 2.7V
+#define CLOCK_PROFILE_BOOST_WAIT_STATES 1
+
+/// Sets up the clock SERCOM0 needs for its bus speed.  Call before I2C_0 is
+/// enabled.
+void clock_profile_init(void);
+
+#if CLOCK_PROFILES_ENABLED
+
+/// Starts the CPU switching to the DFLL, if it's not already, without waiting
+/// for it.  Safe from interrupt handlers.
+void clock_profile_boost(void);
+
+/// Switches the CPU back to OSC8M, waiting until it's done.  Call with
+/// interrupts masked, so a boost can't come in half way.
+void clock_profile_low(void);
+
+#else
+
+static inline void clock_profile_boost(void)
+{
+}
+
+static inline void clock_profile_low(void)
+{
+}
+
+#endif // CLOCK_PROFILES_ENABLED
+
+#endif // CLOCK_PROFILE_H_INCLUDED
@@ -14,6 +14,12 @@
 #define CONF_SERCOM_0_I2CS_ENABLE 1
 #endif
 
+// Set to 0 to leave SERCOM0_Handler out of hpl_sercom.c, for the application
+// to define its own.  0 builds the fast path I2C slave, see iic_fast.h.
+#ifndef CONF_SERCOM_0_HPL_HANDLER
+#define CONF_SERCOM_0_HPL_HANDLER 1
+#endif
+
 // <h> Basic Configuration
 
 // <o> Address <0x0-0x3FF>
@@ -28,14 +34,24 @@
 // <e> Advanced Configuration
 // <id> i2c_slave_advanced
 #ifndef CONF_SERCOM_0_I2CS_ADVANCED_CONFIG
-#define CONF_SERCOM_0_I2CS_ADVANCED_CONFIG 0
+#define CONF_SERCOM_0_I2CS_ADVANCED_CONFIG 1
+#endif
+
+// <o> Speed (SPEED)
+// <0=>Standard-mode and Fast-mode, up to 400kHz
+// <1=>Fast-mode Plus, up to 1MHz
+// <2=>High-speed mode, up to 3.4MHz
+// <i> Faster than Fast-mode needs SERCOM0's core clock from the DFLL, see clock_profile.h
+// <id> i2c_slave_speed
+#ifndef CONF_SERCOM_0_I2CS_SPEED
+#define CONF_SERCOM_0_I2CS_SPEED 0x0
 #endif
 
 // <q> Run in stand-by
 // <i> Determine if the module shall run in standby sleep mode
 // <id> i2c_slave_runstdby
 #ifndef CONF_SERCOM_0_I2CS_RUNSTDBY
-#define CONF_SERCOM_0_I2CS_RUNSTDBY 0
+#define CONF_SERCOM_0_I2CS_RUNSTDBY 1
 #endif
 
 // <o> SDA Hold Time (SDAHOLD)
@@ -44,9 +60,10 @@
 // <2=>300-600ns hold time
 // <3=>400-800ns hold time
 // <i> Defines the SDA hold time with respect to the negative edge of SCL
+// <i> Fast-mode Plus and High-speed mode need the data valid sooner than 300ns
 // <id> i2c_slave_sdahold
 #ifndef CONF_SERCOM_0_I2CS_SDAHOLD
-#define CONF_SERCOM_0_I2CS_SDAHOLD 0x2
+#define CONF_SERCOM_0_I2CS_SDAHOLD (CONF_SERCOM_0_I2CS_SPEED ? 0x1 : 0x2)
 #endif
 
 // <q> Slave SCL Low Extend Time-Out (SEXTTOEN)
@@ -64,17 +81,18 @@
 #endif
 
 // <q> SCL Clock Stretch Mode (SCLSM)
-// <i> Enables SCL stretching.
+// <i> Stretches SCL after the ACK bit instead of before it, so the hardware sends the ACK from ACKACT as it was when the byte arrived
+// <i> High-speed mode needs it, and Fast-mode Plus uses it so the ACK doesn't wait for the CPU or DMAC
 // <id> i2c_slave_sclsm
 #ifndef CONF_SERCOM_0_I2CS_SCLSM
-#define CONF_SERCOM_0_I2CS_SCLSM 0
+#define CONF_SERCOM_0_I2CS_SCLSM (CONF_SERCOM_0_I2CS_SPEED ? 1 : 0)
 #endif
 
 // <q> General call addressing (GENCEN)
 // <i> Enables general call addressing
 // <id> i2c_slave_gencen
 #ifndef CONF_SERCOM_0_I2CS_GENCEN
-#define CONF_SERCOM_0_I2CS_GENCEN 0
+#define CONF_SERCOM_0_I2CS_GENCEN 1
 #endif
 
 // <o> Address mode (AMODE)
@@ -103,8 +121,12 @@
 #endif
 // </e>
 
-#ifndef CONF_SERCOM_0_I2CS_SPEED
-#define CONF_SERCOM_0_I2CS_SPEED 0x00 // Speed: Standard/Fast mode
+#if CONF_SERCOM_0_I2CS_SPEED == 0x2 && !CONF_SERCOM_0_I2CS_SCLSM
+#error "High-speed mode needs SCLSM"
+#endif
+
+#if CONF_SERCOM_0_I2CS_SPEED && CONF_SERCOM_0_I2CS_SDAHOLD > 0x1
+#error "SDA hold time too long for Fast-mode Plus or High-speed mode"
 #endif
 
 // <<< end of configuration section >>>
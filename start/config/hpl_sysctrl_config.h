@@ -72,7 +72,7 @@
 // <i> If this bit is 1: The oscillator is not stopped in standby sleep mode.
 // <id> osc8m_arch_runstdby
 #ifndef CONF_OSC8M_RUNSTDBY
-#define CONF_OSC8M_RUNSTDBY 0
+#define CONF_OSC8M_RUNSTDBY 1
 #endif
 
 // <y> Prescaler
@@ -410,7 +410,7 @@
 // <i> Indicates whether configuration for DFLL is enabled or not
 // <id> enable_dfll48m
 #ifndef CONF_DFLL_CONFIG
-#define CONF_DFLL_CONFIG 0
+#define CONF_DFLL_CONFIG 1
 #endif
 
 // <y> Reference Clock Source
@@ -433,7 +433,7 @@
 // <i> Indicates whether DFLL is enabled or not
 // <id> dfll48m_arch_enable
 #ifndef CONF_DFLL_ENABLE
-#define CONF_DFLL_ENABLE 0
+#define CONF_DFLL_ENABLE 1
 #endif
 
 // <q> Wait Lock
@@ -479,7 +479,7 @@
 // <i> If this bit is 1: The DFLL is not stopped in standby sleep mode.
 // <id> dfll48m_arch_runstdby
 #ifndef CONF_DFLL_RUNSTDBY
-#define CONF_DFLL_RUNSTDBY 0
+#define CONF_DFLL_RUNSTDBY 1
 #endif
 
 // <q> Lose Lock After Wake
@@ -37,7 +37,7 @@
 // <e> Advanced configuration
 // <id> timer_advanced_configuration
 #ifndef CONF_TC1__ADVANCED_CONFIGURATION_ENABLE
-#define CONF_TC1__ADVANCED_CONFIGURATION_ENABLE 0
+#define CONF_TC1__ADVANCED_CONFIGURATION_ENABLE 1
 #endif
 
 // <y> Prescaler and Counter Synchronization Selection
@@ -54,7 +54,7 @@
 // <i> Indicates whether the module will continue to run in standby sleep mode
 // <id> tc_arch_runstdby
 #ifndef CONF_TC1_RUNSTDBY
-#define CONF_TC1_RUNSTDBY 0
+#define CONF_TC1_RUNSTDBY 1
 #endif
 
 // <q> Run in debug mode
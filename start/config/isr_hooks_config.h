@@ -0,0 +1,65 @@
+/* Hooks the application hangs off the HAL and HPL interrupt paths */
+#ifndef ISR_HOOKS_CONFIG_H
+#define ISR_HOOKS_CONFIG_H
+
+// The drivers include this instead of any of the application's headers, and
+// each hook is empty unless it's switched on here, leaving the driver as ASF
+// has it.
+
+#include <compiler.h>
+#include <hpl_pm_config.h>
+#include <utils.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <q> Time the interrupt handlers
+// <i> Records SERCOM0_Handler, TC1_Handler and timer_process_counted() in bench_stats, see bench.h
+// <id> isr_hooks_bench
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED 1
+#endif
+
+// <q> Run the interrupt path from SRAM
+// <i> Puts the handlers marked CONF_ISR_ATTR in .ramfunc, see ramfunc.h. On by default when flash has wait states.
+// <id> isr_hooks_ramfunc
+#ifndef RAMFUNC_ENABLED
+#define RAMFUNC_ENABLED (CONF_NVM_WAIT_STATE > 0)
+#endif
+
+// <<< end of configuration section >>>
+
+// Attribute for the functions on every interrupt of the I2C to display path
+#if RAMFUNC_ENABLED
+#define CONF_ISR_ATTR RAMFUNC
+#else
+#define CONF_ISR_ATTR
+#endif
+
+// Probes inside the drivers, numbered as the first of bench.h's probes
+#define CONF_BENCH_PROBE_SERCOM0_HANDLER 0
+#define CONF_BENCH_PROBE_TC1_HANDLER 1
+#define CONF_BENCH_PROBE_TIMER_PROCESS 2
+
+#if BENCH_ENABLED
+
+// bench_record() for a probe by its number, defined in bench.c
+void bench_record_hook(uint8_t probe, uint32_t cycles);
+
+// Times from here to the matching CONF_ISR_BENCH_END() in the same block, in
+// SysTick cycles like bench.h's BENCH_BEGIN() and BENCH_END()
+#define CONF_ISR_BENCH_BEGIN(probe) const uint32_t isr_bench_start_##probe = SysTick->VAL
+#define CONF_ISR_BENCH_END(probe)                                                                                      \
+	bench_record_hook(CONF_BENCH_PROBE_##probe, (isr_bench_start_##probe - SysTick->VAL) & SysTick_LOAD_RELOAD_Msk)
+
+#else
+
+#define CONF_ISR_BENCH_BEGIN(probe)                                                                                    \
+	do {                                                                                                               \
+	} while (0)
+#define CONF_ISR_BENCH_END(probe)                                                                                      \
+	do {                                                                                                               \
+	} while (0)
+
+#endif // BENCH_ENABLED
+
+#endif // ISR_HOOKS_CONFIG_H
@@ -29,7 +29,7 @@
 
 // <i> Select the clock source for CORE.
 #ifndef CONF_GCLK_SERCOM0_CORE_SRC
-#define CONF_GCLK_SERCOM0_CORE_SRC GCLK_CLKCTRL_GEN_GCLK0_Val
+#define CONF_GCLK_SERCOM0_CORE_SRC GCLK_CLKCTRL_GEN_GCLK1_Val
 #endif
 
 // <y> Slow Clock Source
@@ -49,7 +49,7 @@
 
 // <i> Select the slow clock source.
 #ifndef CONF_GCLK_SERCOM0_SLOW_SRC
-#define CONF_GCLK_SERCOM0_SLOW_SRC GCLK_CLKCTRL_GEN_GCLK0_Val
+#define CONF_GCLK_SERCOM0_SLOW_SRC GCLK_CLKCTRL_GEN_GCLK1_Val
 #endif
 
 /**
@@ -85,7 +85,7 @@
 
 // <i> Select the clock source for TC.
 #ifndef CONF_GCLK_TC1_SRC
-#define CONF_GCLK_TC1_SRC GCLK_CLKCTRL_GEN_GCLK0_Val
+#define CONF_GCLK_TC1_SRC GCLK_CLKCTRL_GEN_GCLK1_Val
 #endif
 
 /**
@@ -0,0 +1,399 @@
+// Seven segment display output
+//
+#include "display.h"
+
+#include "bench.h"
+#include "ramfunc.h"
+#include "pwm.h"
+
+// All the segments are on PORTA, so a whole digit is one PORTA bit mask
+#define SEGMENT_PORT GPIO_PORTA
+
+#define SEGMENT_A_MASK (1UL << GPIO_PIN(SEGMENT_A_PIN))
+#define SEGMENT_B_MASK (1UL << GPIO_PIN(SEGMENT_B_PIN))
+#define SEGMENT_C_MASK (1UL << GPIO_PIN(SEGMENT_C_PIN))
+#define SEGMENT_D_MASK (1UL << GPIO_PIN(SEGMENT_D_PIN))
+#define SEGMENT_E_MASK (1UL << GPIO_PIN(SEGMENT_E_PIN))
+#define SEGMENT_F_MASK (1UL << GPIO_PIN(SEGMENT_F_PIN))
+#define SEGMENT_G_MASK (1UL << GPIO_PIN(SEGMENT_G_PIN))
+
+#define SEGMENT_ALL_MASK (SEGMENT_A_MASK | SEGMENT_B_MASK | SEGMENT_C_MASK | \
+                          SEGMENT_D_MASK | SEGMENT_E_MASK | SEGMENT_F_MASK | \
+                          SEGMENT_G_MASK)
+
+// Segments on TCC0 outputs, each with an output of its own so pwm_hold_low()
+// can turn it off.  CC2 belongs to the heartbeat, so these stick to outputs
+// of CC0, CC1 and CC3, which all hold the segment brightness.
+#define SEGMENT_A_PINMUX PINMUX_PA25F_TCC0_WO5
+#define SEGMENT_B_PINMUX PINMUX_PA24F_TCC0_WO4
+#define SEGMENT_D_PINMUX PINMUX_PA04F_TCC0_WO0
+#define SEGMENT_E_PINMUX PINMUX_PA05F_TCC0_WO1
+#define SEGMENT_G_PINMUX PINMUX_PA09E_TCC0_WO3
+
+// C has no TCC0 output, and F could only have WO2 (the heartbeat's) or WO4
+// (B's), so those two are PWMed in software from the TCC0 interrupt
+#define SOFT_SEGMENT_MASK (SEGMENT_C_MASK | SEGMENT_F_MASK)
+
+// CC channel whose match ends the lit part of the software PWM
+#define SOFT_SEGMENT_CC 0
+
+/// A segment driven by TCC0
+struct pwm_segment {
+    uint32_t port_mask;
+    uint32_t pin;
+    uint32_t pinmux;
+    uint8_t  wo;
+};
+
+static const struct pwm_segment pwm_segments[] = {
+    {SEGMENT_A_MASK, SEGMENT_A_PIN, SEGMENT_A_PINMUX, 5},
+    {SEGMENT_B_MASK, SEGMENT_B_PIN, SEGMENT_B_PINMUX, 4},
+    {SEGMENT_D_MASK, SEGMENT_D_PIN, SEGMENT_D_PINMUX, 0},
+    {SEGMENT_E_MASK, SEGMENT_E_PIN, SEGMENT_E_PINMUX, 1},
+    {SEGMENT_G_MASK, SEGMENT_G_PIN, SEGMENT_G_PINMUX, 3},
+};
+
+// Brightness CC channels, those driving at least one segment output
+static const uint8_t segment_ccs[] = {0, 1, 3};
+
+/// PORTA bits to light for each digit
+static const uint32_t digit_masks[] = {
+    /* 0 */ SEGMENT_A_MASK | SEGMENT_B_MASK | SEGMENT_C_MASK |
+            SEGMENT_E_MASK | SEGMENT_F_MASK | SEGMENT_G_MASK,
+    /* 1 */ SEGMENT_F_MASK | SEGMENT_G_MASK,
+    /* 2 */ SEGMENT_A_MASK | SEGMENT_B_MASK | SEGMENT_D_MASK |
+            SEGMENT_E_MASK | SEGMENT_G_MASK,
+    /* 3 */ SEGMENT_A_MASK | SEGMENT_D_MASK | SEGMENT_E_MASK |
+            SEGMENT_F_MASK | SEGMENT_G_MASK,
+    /* 4 */ SEGMENT_C_MASK | SEGMENT_D_MASK | SEGMENT_F_MASK |
+            SEGMENT_G_MASK,
+    /* 5 */ SEGMENT_A_MASK | SEGMENT_C_MASK | SEGMENT_D_MASK |
+            SEGMENT_E_MASK | SEGMENT_F_MASK,
+    /* 6 */ SEGMENT_A_MASK | SEGMENT_B_MASK | SEGMENT_C_MASK |
+            SEGMENT_D_MASK | SEGMENT_E_MASK | SEGMENT_F_MASK,
+    /* 7 */ SEGMENT_E_MASK | SEGMENT_F_MASK | SEGMENT_G_MASK,
+    /* 8 */ SEGMENT_A_MASK | SEGMENT_B_MASK | SEGMENT_C_MASK |
+            SEGMENT_D_MASK | SEGMENT_E_MASK | SEGMENT_F_MASK |
+            SEGMENT_G_MASK,
+    /* 9 */ SEGMENT_C_MASK | SEGMENT_D_MASK | SEGMENT_E_MASK |
+            SEGMENT_F_MASK | SEGMENT_G_MASK,
+};
+
+// Glyphs for show_glyph(), as SEGMENT_x_BITs
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST  'z'
+#define GLYPH(c) [(c) - GLYPH_FIRST]
+
+#define GLYPH_A (SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT)
+#define GLYPH_b (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT)
+#define GLYPH_d (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT)
+#define GLYPH_E (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT)
+#define GLYPH_F (SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT)
+#define GLYPH_G (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_E_BIT | SEGMENT_F_BIT)
+#define GLYPH_I (SEGMENT_B_BIT | SEGMENT_C_BIT)
+#define GLYPH_J (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT)
+#define GLYPH_L (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT)
+#define GLYPH_n (SEGMENT_B_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT)
+#define GLYPH_P (SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT | SEGMENT_G_BIT)
+#define GLYPH_q (SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT)
+#define GLYPH_r (SEGMENT_B_BIT | SEGMENT_D_BIT)
+#define GLYPH_S (SEGMENT_A_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_E_BIT | SEGMENT_F_BIT)
+#define GLYPH_t (SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT)
+#define GLYPH_y (SEGMENT_A_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT)
+
+/// Segments to light for each character show_glyph() knows, the rest are 0.
+/// Digits go through show_digit() instead.
+static const uint8_t glyphs[GLYPH_LAST - GLYPH_FIRST + 1] = {
+    GLYPH('"') = SEGMENT_C_BIT | SEGMENT_G_BIT,
+    GLYPH('-') = SEGMENT_D_BIT,
+    GLYPH('=') = SEGMENT_A_BIT | SEGMENT_D_BIT,
+    GLYPH('_') = SEGMENT_A_BIT,
+
+    GLYPH('A') = GLYPH_A, GLYPH('a') = GLYPH_A,
+    GLYPH('B') = GLYPH_b, GLYPH('b') = GLYPH_b,
+    GLYPH('C') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_E_BIT,
+    GLYPH('c') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_D_BIT,
+    GLYPH('D') = GLYPH_d, GLYPH('d') = GLYPH_d,
+    GLYPH('E') = GLYPH_E, GLYPH('e') = GLYPH_E,
+    GLYPH('F') = GLYPH_F, GLYPH('f') = GLYPH_F,
+    GLYPH('G') = GLYPH_G, GLYPH('g') = GLYPH_G,
+    GLYPH('H') = SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT,
+    GLYPH('h') = SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT,
+    GLYPH('I') = GLYPH_I,
+    GLYPH('i') = SEGMENT_F_BIT,
+    GLYPH('J') = GLYPH_J, GLYPH('j') = GLYPH_J,
+    GLYPH('L') = GLYPH_L, GLYPH('l') = GLYPH_I,
+    GLYPH('N') = GLYPH_n, GLYPH('n') = GLYPH_n,
+    GLYPH('O') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_E_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT,
+    GLYPH('o') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_D_BIT | SEGMENT_F_BIT,
+    GLYPH('P') = GLYPH_P, GLYPH('p') = GLYPH_P,
+    GLYPH('Q') = GLYPH_q, GLYPH('q') = GLYPH_q,
+    GLYPH('R') = GLYPH_r, GLYPH('r') = GLYPH_r,
+    GLYPH('S') = GLYPH_S, GLYPH('s') = GLYPH_S,
+    GLYPH('T') = GLYPH_t, GLYPH('t') = GLYPH_t,
+    GLYPH('U') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_C_BIT | SEGMENT_F_BIT | SEGMENT_G_BIT,
+    GLYPH('u') = SEGMENT_A_BIT | SEGMENT_B_BIT | SEGMENT_F_BIT,
+    GLYPH('Y') = GLYPH_y, GLYPH('y') = GLYPH_y,
+};
+
+/// PORTA bit for each SEGMENT_x_BIT, in bit order
+static const uint32_t segment_masks[] = {
+    SEGMENT_A_MASK,
+    SEGMENT_B_MASK,
+    SEGMENT_C_MASK,
+    SEGMENT_D_MASK,
+    SEGMENT_E_MASK,
+    SEGMENT_F_MASK,
+    SEGMENT_G_MASK,
+};
+
+/// PORTA bits that should be lit, when the display isn't blanked
+static volatile uint32_t shown_mask = 0;
+
+/// Pattern waiting for display_commit(), while latched
+static uint32_t staged_mask = 0;
+static bool staged = false;
+static bool latched = false;
+
+static volatile uint8_t display_brightness = 0xFF;
+
+/// True during the dark half of a blink
+static volatile bool blink_off = false;
+
+static struct timer_task blink_task;
+static bool blinking = false;
+
+/// Set by display_set_hidden()
+static volatile bool hidden = false;
+
+/// PORTA bits shown instead of shown_mask, while overlaid
+static volatile uint32_t overlay_mask = 0;
+static volatile bool overlaid = false;
+
+/// Software PWMed segments that should be lit, while they're being PWMed
+static volatile uint32_t soft_lit_mask = 0;
+
+/// Sets the segment outputs to exactly the segments in port_mask
+///
+/// The TCC0 segments change with a single write to PATT, and the others with a
+/// single write to OUTTGL, with interrupts masked so nothing happens between
+/// the two.  The blink task also writes the segments, so the read and write of
+/// OUT are in the same critical section.
+static inline void write_segments(uint32_t port_mask)
+{
+    uint8_t held_low = 0;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(pwm_segments); ++i) {
+        if (!(port_mask & pwm_segments[i].port_mask)) {
+            held_low |= 1 << pwm_segments[i].wo;
+        }
+    }
+
+    // At full brightness the software segments are just left on
+    bool soft_pwm = display_brightness != 0xFF && (port_mask & SOFT_SEGMENT_MASK);
+
+    CRITICAL_SECTION_ENTER()
+    uint32_t changed = (hri_port_read_OUT_reg(PORT_IOBUS, SEGMENT_PORT) ^ port_mask) & SOFT_SEGMENT_MASK;
+
+    pwm_hold_low(held_low);
+    gpio_toggle_port_level(SEGMENT_PORT, changed);
+
+    soft_lit_mask = port_mask & SOFT_SEGMENT_MASK;
+    if (soft_pwm) {
+        hri_tcc_set_INTEN_reg(TCC0, TCC_INTENSET_OVF | TCC_INTENSET_MC0);
+    } else {
+        hri_tcc_clear_INTEN_reg(TCC0, TCC_INTENSET_OVF | TCC_INTENSET_MC0);
+    }
+    CRITICAL_SECTION_LEAVE()
+}
+
+/// Runs the software PWM for segments without a TCC0 output
+///
+/// Only enabled while one of them is lit at partial brightness, so it costs
+/// nothing at full brightness or when they're off.  TCC0 has no other users of
+/// its interrupt.
+HOT_RAMFUNC void TCC0_Handler(void)
+{
+    if (hri_tcc_get_interrupt_OVF_bit(TCC0)) {
+        hri_tcc_clear_interrupt_OVF_bit(TCC0);
+        gpio_set_port_level(SEGMENT_PORT, soft_lit_mask, true);
+    }
+
+    if (hri_tcc_get_interrupt_MC0_bit(TCC0)) {
+        hri_tcc_clear_interrupt_MC0_bit(TCC0);
+        gpio_set_port_level(SEGMENT_PORT, SOFT_SEGMENT_MASK, false);
+    }
+}
+
+HOT_RAMFUNC static void display_refresh(void)
+{
+    if (blink_off || hidden || display_brightness == 0) {
+        write_segments(0);
+    } else if (overlaid) {
+        write_segments(overlay_mask);
+    } else {
+        write_segments(shown_mask);
+    }
+}
+
+void display_init(void)
+{
+    gpio_set_port_level(SEGMENT_PORT, SEGMENT_ALL_MASK, 0);
+    gpio_set_port_direction(SEGMENT_PORT, SEGMENT_ALL_MASK, GPIO_DIRECTION_OUT);
+
+    // Everything is held low until there's something to show
+    pwm_hold_low(0xFF);
+    for (uint8_t i = 0; i < ARRAY_SIZE(segment_ccs); ++i) {
+        pwm_set_duty(segment_ccs[i], PWM_PERIOD_TICKS);
+    }
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(pwm_segments); ++i) {
+        gpio_set_pin_function(pwm_segments[i].pin, pwm_segments[i].pinmux);
+    }
+
+    NVIC_EnableIRQ(TCC0_IRQn);
+}
+
+/// Shows port_mask now, or stages it for display_commit() if latched
+static void display_set_mask(uint32_t port_mask)
+{
+    if (latched) {
+        staged_mask = port_mask;
+        staged = true;
+    } else {
+        shown_mask = port_mask;
+        display_refresh();
+    }
+}
+
+HOT_RAMFUNC void show_digit(uint8_t value)
+{
+    BENCH_BEGIN(BENCH_SHOW_DIGIT);
+    if (value < ARRAY_SIZE(digit_masks)) {
+        display_set_mask(digit_masks[value]);
+    } else {
+        display_set_mask(0);
+    }
+    BENCH_END(BENCH_SHOW_DIGIT);
+}
+
+/// PORTA bits for a pattern of SEGMENT_x_BITs
+static uint32_t segments_to_mask(uint8_t segments)
+{
+    uint32_t port_mask = 0;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(segment_masks); ++i) {
+        if (segments & (1 << i)) {
+            port_mask |= segment_masks[i];
+        }
+    }
+
+    return port_mask;
+}
+
+void show_segments(uint8_t segments)
+{
+    display_set_mask(segments_to_mask(segments));
+}
+
+uint8_t display_get_segments(void)
+{
+    uint32_t port_mask = shown_mask;
+    uint8_t segments = 0;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(segment_masks); ++i) {
+        if (port_mask & segment_masks[i]) {
+            segments |= 1 << i;
+        }
+    }
+
+    return segments;
+}
+
+void show_glyph(uint8_t character)
+{
+    if (character >= '0' && character <= '9') {
+        show_digit(character - '0');
+    } else if (character >= GLYPH_FIRST && character <= GLYPH_LAST) {
+        show_segments(glyphs[character - GLYPH_FIRST]);
+    } else {
+        show_segments(0);
+    }
+}
+
+void display_set_latched(bool latch)
+{
+    if (latched && !latch) {
+        display_commit();
+    }
+
+    latched = latch;
+}
+
+void display_commit(void)
+{
+    if (staged) {
+        staged = false;
+        shown_mask = staged_mask;
+        display_refresh();
+    }
+}
+
+void display_set_brightness(uint8_t brightness)
+{
+    // Linear in the duty cycle, 0xFF is over the top of the period so always on
+    uint16_t high_ticks = ((uint32_t)brightness * PWM_PERIOD_TICKS + 0xFE) / 0xFF;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(segment_ccs); ++i) {
+        pwm_set_duty(segment_ccs[i], high_ticks);
+    }
+
+    display_brightness = brightness;
+    display_refresh();
+}
+
+static void blink_task_cb(const struct timer_task *const timer_task)
+{
+    blink_off = !blink_off;
+    display_refresh();
+}
+
+void display_set_blink(uint8_t half_period)
+{
+    if (blinking) {
+        timer_remove_task(&TIMER_0, &blink_task);
+        blinking = false;
+    }
+
+    blink_off = false;
+
+    if (half_period) {
+        // TIMER_0 ticks every millisecond
+        blink_task.interval = (uint32_t)half_period * DISPLAY_BLINK_UNIT_MS;
+        blink_task.cb = blink_task_cb;
+        blink_task.mode = TIMER_TASK_REPEAT;
+        timer_add_task(&TIMER_0, &blink_task);
+        blinking = true;
+    }
+
+    display_refresh();
+}
+
+void display_set_hidden(bool hide)
+{
+    hidden = hide;
+    display_refresh();
+}
+
+void display_set_overlay(uint8_t segments)
+{
+    overlay_mask = segments_to_mask(segments);
+    overlaid = true;
+    display_refresh();
+}
+
+void display_clear_overlay(void)
+{
+    overlaid = false;
+    display_refresh();
+}
@@ -0,0 +1,85 @@
+// Seven segment display output
+//
+#ifndef DISPLAY_H_INCLUDED
+#define DISPLAY_H_INCLUDED
+
+#include <atmel_start.h>
+
+// Segments are encoded as seen from font:
+//
+//  --E--
+// |     |
+// C     G
+// |--D--|
+// B     F
+// |     |
+//  --A--
+
+#define SEGMENT_A_PIN PIN_PA25
+#define SEGMENT_B_PIN PIN_PA24
+#define SEGMENT_C_PIN PIN_PA02
+#define SEGMENT_D_PIN PIN_PA04
+#define SEGMENT_E_PIN PIN_PA05
+#define SEGMENT_F_PIN PIN_PA08
+#define SEGMENT_G_PIN PIN_PA09
+
+// Bits of a segment pattern, as taken by show_segments()
+#define SEGMENT_A_BIT 0x01
+#define SEGMENT_B_BIT 0x02
+#define SEGMENT_C_BIT 0x04
+#define SEGMENT_D_BIT 0x08
+#define SEGMENT_E_BIT 0x10
+#define SEGMENT_F_BIT 0x20
+#define SEGMENT_G_BIT 0x40
+
+/// Blink half periods are counted in these
+#define DISPLAY_BLINK_UNIT_MS 10
+
+/// Makes the segment pins outputs, with everything off.  Call after pwm_init().
+void display_init(void);
+
+/// Shows a digit 0-9, anything else blanks the display
+void show_digit(uint8_t value);
+
+/// Shows an arbitrary pattern of SEGMENT_x_BITs
+void show_segments(uint8_t segments);
+
+/// Shows an ASCII character as best it can be on seven segments
+///
+/// Covers the digits, the hex digits, most letters in whichever case looks
+/// right, and a few symbols (space - _ = ").  Anything else blanks the display.
+void show_glyph(uint8_t character);
+
+/// SEGMENT_x_BITs last shown by show_digit(), show_segments() or show_glyph(),
+/// whether or not they're blinked, blanked or overlaid just now
+uint8_t display_get_segments(void);
+
+/// While latched, show_digit() and show_segments() only stage the new pattern,
+/// and it doesn't appear until display_commit()
+void display_set_latched(bool latched);
+
+/// Shows the pattern staged while latched, if there is one
+void display_commit(void);
+
+/// Sets the PWM duty cycle of the lit segments, 0 blanks the display and 0xFF
+/// leaves them on
+///
+/// Most segments are PWMed by TCC0, but C and F can't be so they're done in
+/// software from the TCC0 interrupt, which wakes the CPU twice a millisecond
+/// while either of them is lit at partial brightness.
+void display_set_brightness(uint8_t brightness);
+
+/// Blinks the display, half_period is in DISPLAY_BLINK_UNIT_MS, 0 is steady
+void display_set_blink(uint8_t half_period);
+
+/// Blanks the display while hidden, without forgetting what it shows
+void display_set_hidden(bool hidden);
+
+/// Shows a pattern of SEGMENT_x_BITs over the top of whatever show_digit() and
+/// show_segments() last set, until display_clear_overlay().  Not latched.
+void display_set_overlay(uint8_t segments);
+
+/// Goes back to showing what was there before display_set_overlay()
+void display_clear_overlay(void);
+
+#endif // DISPLAY_H_INCLUDED
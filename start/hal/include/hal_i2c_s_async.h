@@ -71,7 +71,14 @@ typedef void (*i2c_s_async_cb_t)(const struct i2c_s_async_descriptor *const desc
 /**
  * \brief i2c callback types
  */
-enum i2c_s_async_callback_type { I2C_S_ERROR, I2C_S_TX_PENDING, I2C_S_TX_COMPLETE, I2C_S_RX_COMPLETE };
+enum i2c_s_async_callback_type {
+	I2C_S_ERROR,
+	I2C_S_TX_PENDING,
+	I2C_S_TX_COMPLETE,
+	I2C_S_RX_COMPLETE,
+	I2C_S_STOP,
+	I2C_S_ADDRESS_MATCH
+};
 
 /**
  * \brief i2c callback pointers structure
@@ -81,6 +88,16 @@ struct i2c_s_async_callbacks {
 	i2c_s_async_cb_t tx_pending;
 	i2c_s_async_cb_t tx;
 	i2c_s_async_cb_t rx;
+	i2c_s_async_cb_t stop;
+	i2c_s_async_cb_t addr_match;
+};
+
+/**
+ * \brief What to do with a received byte when the rx buffer is full
+ */
+enum i2c_s_async_rx_overflow {
+	I2C_S_RX_OVERFLOW_NACK,   /* NACK the byte (the next one with SCLSM), so the master stops writing */
+	I2C_S_RX_OVERFLOW_STRETCH /* Hold SCL low until the buffer is read from */
 };
 
 /**
@@ -91,6 +108,12 @@ struct i2c_s_async_descriptor {
 	struct io_descriptor         io;
 	struct i2c_s_async_callbacks cbs;
 	struct ringbuffer            rx;
+	enum i2c_s_async_rx_overflow rx_overflow;
+	uint16_t                     rx_transaction_length;
+	volatile bool                rx_held;
+	bool                         rx_nacked;
+	volatile uint32_t            rx_nacks;
+	volatile uint32_t            rx_holds;
 	uint8_t *                    tx_buffer;
 	uint16_t                     tx_buffer_length;
 	uint16_t                     tx_por;
@@ -229,6 +252,44 @@ int32_t i2c_s_async_get_bytes_sent(const struct i2c_s_async_descriptor *const de
  */
 int32_t i2c_s_async_flush_rx_buffer(struct i2c_s_async_descriptor *const descr);
 
+/**
+ * \brief Set what happens to received bytes when the rx buffer is full
+ *
+ * Either way no received byte is lost silently.  NACK, the default, cuts the
+ * write short.  STRETCH holds SCL low until the buffer is read from, which
+ * only helps if there are bytes from earlier transactions to read.  So a
+ * transaction that fills the whole buffer by itself is NACKed regardless.
+ *
+ * \param[in] descr An I2C slave descriptor which is used to communicate through
+ * \param[in] overflow What to do with a byte that doesn't fit
+ *
+ * \return The status of setting the overflow mode
+ */
+int32_t i2c_s_async_set_rx_overflow(struct i2c_s_async_descriptor *const descr,
+                                    const enum i2c_s_async_rx_overflow overflow);
+
+/**
+ * \brief Retrieve the number of writes cut short with a NACK
+ *
+ * This function retrieves the number of write transactions with a byte NACKed
+ * for want of space in the rx buffer, since initialization.  A write is only
+ * counted once, however many of its bytes are NACKed.
+ *
+ * \param[in] descr An I2C slave descriptor which is used to communicate through
+ *
+ * \return The number of writes NACKed
+ */
+uint32_t i2c_s_async_get_rx_nacks(const struct i2c_s_async_descriptor *const descr);
+
+/**
+ * \brief Retrieve the number of times SCL was held for rx buffer space
+ *
+ * \param[in] descr An I2C slave descriptor which is used to communicate through
+ *
+ * \return The number of times the bus was held
+ */
+uint32_t i2c_s_async_get_rx_holds(const struct i2c_s_async_descriptor *const descr);
+
 /**
  * \brief Abort sending
  *
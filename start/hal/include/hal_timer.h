@@ -57,6 +57,46 @@ extern "C" {
  * @{
  */
 
+/**
+ * \brief Keep timer tasks in a hierarchical timer wheel, rather than a list
+ *
+ * The sorted list costs O(n) to add a task, and to re-add a repeating one in
+ * the timer interrupt.  The wheel re-adds a repeating task in O(1) and
+ * expires the ones due each tick in O(1), moving tasks down a level at most
+ * TIMER_WHEEL_LEVELS - 1 times.  timer_add_task() and timer_remove_task()
+ * check the one slot a task was last put in, so cost as many steps as there
+ * are tasks sharing it.  Build with -DTIMER_WHEEL_ENABLED=0 for the list.
+ */
+#ifndef TIMER_WHEEL_ENABLED
+#define TIMER_WHEEL_ENABLED 1
+#endif
+
+#if TIMER_WHEEL_ENABLED
+/**
+ * \brief Timer wheel geometry
+ *
+ * Each level has TIMER_WHEEL_SLOTS slots, each slot covering TIMER_WHEEL_SLOTS
+ * times as many ticks as one on the level below.  Tasks due further off than
+ * the whole wheel covers wait in the top level, and are moved again until due.
+ */
+#define TIMER_WHEEL_SLOT_BITS 4
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_SLOT_BITS)
+#define TIMER_WHEEL_LEVELS 4
+#endif
+
+/**
+ * \brief Only interrupt when a timer task is due, rather than every tick
+ *
+ * Each timer period is stretched over as many ticks as there are until the
+ * next task is due, by programming the compare register that ends it.  When
+ * the period ends, all the ticks in it are counted at once.  Adding or
+ * removing a task moves the end of the period being counted.  Build with
+ * -DTIMER_TICKLESS_ENABLED=0 to interrupt every tick.
+ */
+#ifndef TIMER_TICKLESS_ENABLED
+#define TIMER_TICKLESS_ENABLED 1
+#endif
+
 /**
  * \brief Timer mode type
  */
@@ -84,16 +124,29 @@ struct timer_task {
 	uint32_t             interval; /*! Number of timer ticks before calling the task. */
 	timer_cb_t           cb;       /*! Function pointer to the task. */
 	enum timer_task_mode mode;     /*! Task mode: one shot or repeat. */
+#if TIMER_WHEEL_ENABLED
+	struct list_descriptor *slot; /*! Wheel slot, or wheel_due, the task was last put in. */
+#endif
 };
 
 /**
  * \brief Timer structure
  */
 struct timer_descriptor {
-	struct _timer_device   device;
-	uint32_t               time;
+	struct _timer_device device;
+	uint32_t             time;
+#if TIMER_TICKLESS_ENABLED
+	uint32_t cycles_per_tick;  /*! As set, the period is a multiple of it. */
+	uint32_t ticks_per_period; /*! Ticks the current period counts. */
+#endif
+#if TIMER_WHEEL_ENABLED
+	uint32_t               wheel_time; /*! Last tick the wheel has been run for. */
+	struct list_descriptor wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS]; /*! Timer tasks by due time. */
+	struct list_descriptor wheel_due; /*! Tasks due this tick not yet run, while the tick is run. */
+#else
 	struct list_descriptor tasks; /*! Timer tasks list. */
-	volatile uint8_t       flags;
+#endif
+	volatile uint8_t flags;
 };
 
 /**
@@ -201,6 +254,18 @@ int32_t timer_add_task(struct timer_descriptor *const descr, struct timer_task *
  */
 int32_t timer_remove_task(struct timer_descriptor *const descr, const struct timer_task *const task);
 
+/**
+ * \brief Retrieve the current time
+ *
+ * This function returns the ticks counted since the timer was started, which
+ * wrap round after 2^32.  Timer tasks are due by the same count.
+ *
+ * \param[in] descr The timer descriptor of a timer to read
+ *
+ * \return The current time in ticks
+ */
+uint32_t timer_get_ticks(const struct timer_descriptor *const descr);
+
 /**
  * \brief Retrieve the current driver version
  *
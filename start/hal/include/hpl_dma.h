@@ -122,6 +122,17 @@ int32_t _dma_set_source_address(const uint8_t channel, const void *const src);
  */
 int32_t _dma_srcinc_enable(const uint8_t channel, const bool enable);
 
+/**
+ * \brief Enable/disable destination address incrementation during DMA
+ *        transaction
+ *
+ * \param[in] channel DMA channel to set destination address for
+ * \param[in] enable True to enable, false to disable
+ *
+ * \return status of operation
+ */
+int32_t _dma_dstinc_enable(const uint8_t channel, const bool enable);
+
 /**
  * \brief Set the amount of data to be transfered per transaction
  *
@@ -141,6 +152,27 @@ int32_t _dma_set_data_amount(const uint8_t channel, const uint32_t amount);
  */
 int32_t _dma_enable_transaction(const uint8_t channel, const bool software_trigger);
 
+/**
+ * \brief Stop the DMA transaction on the given channel
+ *
+ * Returns once the channel has stopped, and its progress has been written
+ * back.
+ *
+ * \param[in] channel DMA channel to stop
+ *
+ * \return status of operation
+ */
+int32_t _dma_disable_transaction(const uint8_t channel);
+
+/**
+ * \brief Retrieve the amount of data a stopped transaction had left to transfer
+ *
+ * \param[in] channel DMA channel to retrieve the amount for
+ *
+ * \return Data amount not transferred
+ */
+uint32_t _dma_get_remaining_amount(const uint8_t channel);
+
 /**
  * \brief Retrieves DMA resource structure
  *
@@ -54,7 +54,22 @@ extern "C" {
 /**
  * \brief i2c callback types
  */
-enum _i2c_s_async_callback_type { I2C_S_DEVICE_ERROR, I2C_S_DEVICE_TX, I2C_S_DEVICE_RX_COMPLETE };
+enum _i2c_s_async_callback_type {
+	I2C_S_DEVICE_ERROR,
+	I2C_S_DEVICE_TX,
+	I2C_S_DEVICE_RX_COMPLETE,
+	I2C_S_DEVICE_STOP,
+	I2C_S_DEVICE_ADDRESS_MATCH
+};
+
+/**
+ * \brief What to do with a received byte, before it is read
+ */
+enum _i2c_s_rx_action {
+	I2C_S_RX_ACK,  /* Read and acknowledge the byte */
+	I2C_S_RX_NACK, /* Read and drop the byte, not acknowledging it */
+	I2C_S_RX_HOLD  /* Leave the byte, holding SCL low until the RX interrupt is enabled again */
+};
 
 /**
  * \brief Forward declaration of I2C Slave device
@@ -72,7 +87,10 @@ typedef void (*_i2c_s_async_cb_t)(struct _i2c_s_async_device *device);
 struct _i2c_s_async_callback {
 	void (*error)(struct _i2c_s_async_device *const device);
 	void (*tx)(struct _i2c_s_async_device *const device);
+	enum _i2c_s_rx_action (*rx_ready)(struct _i2c_s_async_device *const device);
 	void (*rx_done)(struct _i2c_s_async_device *const device, const uint8_t data);
+	void (*stop)(struct _i2c_s_async_device *const device);
+	void (*addr_match)(struct _i2c_s_async_device *const device);
 };
 
 /**
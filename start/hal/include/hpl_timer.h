@@ -145,6 +145,35 @@ void _timer_set_period(struct _timer_device *const device, const uint32_t clock_
  */
 uint32_t _timer_get_period(const struct _timer_device *const device);
 
+/**
+ * \brief Retrieve the largest timer period
+ *
+ * \param[in] device The pointer to timer device instance
+ *
+ * \return The largest value _timer_set_period() takes
+ */
+uint32_t _timer_get_max_period(const struct _timer_device *const device);
+
+/**
+ * \brief Retrieve timer counter value
+ *
+ * \param[in] device The pointer to timer device instance
+ *
+ * \return Clock cycles counted since the current period started
+ */
+uint32_t _timer_get_counter(const struct _timer_device *const device);
+
+/**
+ * \brief Check if the period has expired, with the interrupt not yet taken
+ *
+ * \param[in] device The pointer to timer device instance
+ *
+ * \return Check status.
+ * \retval true The period has expired
+ * \retval false The period is still running
+ */
+bool _timer_is_period_expired(const struct _timer_device *const device);
+
 /**
  * \brief Check if timer is running
  *
@@ -54,8 +54,26 @@ static int32_t i2c_s_async_write(struct io_descriptor *const io_descr, const uin
 static int32_t i2c_s_async_read(struct io_descriptor *const io_descr, uint8_t *const buf, const uint16_t length);
 
 static void i2c_s_async_tx(struct _i2c_s_async_device *const device);
-static void i2c_s_async_byte_received(struct _i2c_s_async_device *const device, const uint8_t data);
+static enum _i2c_s_rx_action i2c_s_async_rx_ready(struct _i2c_s_async_device *const device);
+static void                  i2c_s_async_byte_received(struct _i2c_s_async_device *const device, const uint8_t data);
 static void i2c_s_async_error(struct _i2c_s_async_device *const device);
+static void i2c_s_async_stop(struct _i2c_s_async_device *const device);
+static void i2c_s_async_addr_match(struct _i2c_s_async_device *const device);
+
+/**
+ * \internal Let a byte held for want of rx buffer space in
+ *
+ * Only called after space has been freed: if the handler holds the byte after
+ * this checks, it saw the buffer with the space already freed, so it won't.
+ *
+ * \param[in] descr The pointer to i2c slave descriptor
+ */
+static void i2c_s_async_rx_space_freed(struct i2c_s_async_descriptor *const descr)
+{
+	if (descr->rx_held) {
+		_i2c_s_async_set_irq_state(&descr->device, I2C_S_DEVICE_RX_COMPLETE, true);
+	}
+}
 
 /**
  * \brief Initialize asynchronous i2c slave interface
@@ -79,9 +97,19 @@ int32_t i2c_s_async_init(struct i2c_s_async_descriptor *const descr, void *const
 	descr->io.read  = i2c_s_async_read;
 	descr->io.write = i2c_s_async_write;
 
-	descr->device.cb.error   = i2c_s_async_error;
-	descr->device.cb.tx      = i2c_s_async_tx;
-	descr->device.cb.rx_done = i2c_s_async_byte_received;
+	descr->device.cb.error      = i2c_s_async_error;
+	descr->device.cb.tx         = i2c_s_async_tx;
+	descr->device.cb.rx_ready   = i2c_s_async_rx_ready;
+	descr->device.cb.rx_done    = i2c_s_async_byte_received;
+	descr->device.cb.stop       = i2c_s_async_stop;
+	descr->device.cb.addr_match = i2c_s_async_addr_match;
+
+	descr->rx_overflow           = I2C_S_RX_OVERFLOW_NACK;
+	descr->rx_transaction_length = 0;
+	descr->rx_held               = false;
+	descr->rx_nacked             = false;
+	descr->rx_nacks              = 0;
+	descr->rx_holds              = 0;
 
 	descr->tx_por           = 0;
 	descr->tx_buffer_length = 0;
@@ -158,6 +186,14 @@ int32_t i2c_s_async_register_callback(struct i2c_s_async_descriptor *const descr
 		descr->cbs.rx = func;
 		_i2c_s_async_set_irq_state(&descr->device, I2C_S_DEVICE_RX_COMPLETE, func != NULL);
 		break;
+	case I2C_S_STOP:
+		descr->cbs.stop = func;
+		_i2c_s_async_set_irq_state(&descr->device, I2C_S_DEVICE_STOP, func != NULL);
+		break;
+	case I2C_S_ADDRESS_MATCH:
+		descr->cbs.addr_match = func;
+		_i2c_s_async_set_irq_state(&descr->device, I2C_S_DEVICE_ADDRESS_MATCH, func != NULL);
+		break;
 	default:
 		return ERR_INVALID_DATA;
 	}
@@ -204,7 +240,43 @@ int32_t i2c_s_async_flush_rx_buffer(struct i2c_s_async_descriptor *const descr)
 {
 	ASSERT(descr);
 
-	return ringbuffer_flush(&descr->rx);
+	ringbuffer_flush(&descr->rx);
+	i2c_s_async_rx_space_freed(descr);
+
+	return ERR_NONE;
+}
+
+/**
+ * \brief Set what happens to received bytes when the rx buffer is full
+ */
+int32_t i2c_s_async_set_rx_overflow(struct i2c_s_async_descriptor *const descr,
+                                    const enum i2c_s_async_rx_overflow overflow)
+{
+	ASSERT(descr);
+
+	descr->rx_overflow = overflow;
+
+	return ERR_NONE;
+}
+
+/**
+ * \brief Retrieve the number of received bytes NACKed
+ */
+uint32_t i2c_s_async_get_rx_nacks(const struct i2c_s_async_descriptor *const descr)
+{
+	ASSERT(descr);
+
+	return descr->rx_nacks;
+}
+
+/**
+ * \brief Retrieve the number of times SCL was held for rx buffer space
+ */
+uint32_t i2c_s_async_get_rx_holds(const struct i2c_s_async_descriptor *const descr)
+{
+	ASSERT(descr);
+
+	return descr->rx_holds;
 }
 
 /**
@@ -261,6 +333,42 @@ static void i2c_s_async_tx(struct _i2c_s_async_device *const device)
 	}
 }
 
+/**
+ * \internal Callback function deciding whether there's room for a byte
+ *
+ * \param[in] device The pointer to i2c slave device
+ *
+ * \return What to do with the byte
+ */
+static enum _i2c_s_rx_action i2c_s_async_rx_ready(struct _i2c_s_async_device *const device)
+{
+	struct i2c_s_async_descriptor *descr = CONTAINER_OF(device, struct i2c_s_async_descriptor, device);
+	uint8_t *                      span;
+
+	if (ringbuffer_spsc_write_span(&descr->rx, &span)) {
+		return I2C_S_RX_ACK;
+	}
+
+	/* Holding waits for the reader, so there must be earlier data for it: the
+	 * buffer is full, so it has some unless this transaction filled all of it.
+	 * rx.size is the index mask, one less than the capacity. */
+	if (descr->rx_overflow == I2C_S_RX_OVERFLOW_STRETCH
+	    && descr->rx_transaction_length < descr->rx.size + 1) {
+		if (!descr->rx_held) {
+			descr->rx_held = true;
+			descr->rx_holds++;
+		}
+		return I2C_S_RX_HOLD;
+	}
+
+	/* Once per transaction, in case the master writes on past the NACK */
+	if (!descr->rx_nacked) {
+		descr->rx_nacked = true;
+		descr->rx_nacks++;
+	}
+	return I2C_S_RX_NACK;
+}
+
 /**
  * \internal Callback function for data receipt
  *
@@ -270,7 +378,12 @@ static void i2c_s_async_byte_received(struct _i2c_s_async_device *const device,
 {
 	struct i2c_s_async_descriptor *descr = CONTAINER_OF(device, struct i2c_s_async_descriptor, device);
 
-	ringbuffer_put(&descr->rx, data);
+	/* i2c_s_async_rx_ready() has made sure there's room */
+	ringbuffer_spsc_put(&descr->rx, data);
+	descr->rx_held = false;
+	if (descr->rx_transaction_length < UINT16_MAX) {
+		descr->rx_transaction_length++;
+	}
 
 	if (descr->cbs.rx) {
 		descr->cbs.rx(descr);
@@ -291,6 +404,37 @@ static void i2c_s_async_error(struct _i2c_s_async_device *const device)
 	}
 }
 
+/**
+ * \internal Callback function for stop condition
+ *
+ * \param[in] device The pointer to i2c slave device
+ */
+static void i2c_s_async_stop(struct _i2c_s_async_device *const device)
+{
+	struct i2c_s_async_descriptor *descr = CONTAINER_OF(device, struct i2c_s_async_descriptor, device);
+
+	descr->rx_transaction_length = 0;
+	descr->rx_nacked             = false;
+
+	if (descr->cbs.stop) {
+		descr->cbs.stop(descr);
+	}
+}
+
+/**
+ * \internal Callback function for address match
+ *
+ * \param[in] device The pointer to i2c slave device
+ */
+static void i2c_s_async_addr_match(struct _i2c_s_async_device *const device)
+{
+	struct i2c_s_async_descriptor *descr = CONTAINER_OF(device, struct i2c_s_async_descriptor, device);
+
+	if (descr->cbs.addr_match) {
+		descr->cbs.addr_match(descr);
+	}
+}
+
 /*
  * \internal Read data from i2c slave interface
  *
@@ -302,18 +446,15 @@ static void i2c_s_async_error(struct _i2c_s_async_device *const device)
  */
 static int32_t i2c_s_async_read(struct io_descriptor *const io, uint8_t *const buf, const uint16_t length)
 {
-	uint16_t                       was_read = 0;
-	uint32_t                       num;
+	uint32_t                       was_read;
 	struct i2c_s_async_descriptor *descr = CONTAINER_OF(io, struct i2c_s_async_descriptor, io);
 
 	ASSERT(io && buf && length);
 
-	CRITICAL_SECTION_ENTER()
-	num = ringbuffer_num(&descr->rx);
-	CRITICAL_SECTION_LEAVE()
-
-	while ((was_read < num) && (was_read < length)) {
-		ringbuffer_get(&descr->rx, &buf[was_read++]);
+	/* The IRQ handler is the only producer, so no need to mask interrupts */
+	was_read = ringbuffer_spsc_read(&descr->rx, buf, length);
+	if (was_read) {
+		i2c_s_async_rx_space_freed(descr);
 	}
 
 	return (int32_t)was_read;
@@ -46,6 +46,7 @@
 #include <utils.h>
 #include <hal_atomic.h>
 #include <hpl_irq.h>
+#include <isr_hooks_config.h>
 
 /**
  * \brief Driver version
@@ -58,7 +59,22 @@
 #define TIMER_FLAG_QUEUE_IS_TAKEN 1
 #define TIMER_FLAG_INTERRUPT_TRIGERRED 2
 
+#if TIMER_WHEEL_ENABLED
+static struct list_descriptor *timer_wheel_find_task(struct timer_descriptor *const timer,
+                                                     const struct timer_task *const task);
+static void                    timer_wheel_insert(struct timer_descriptor *const timer, struct timer_task *const task,
+                                                  const uint32_t next);
+#if TIMER_TICKLESS_ENABLED
+static uint32_t timer_wheel_next_tick(const struct timer_descriptor *const timer);
+static uint32_t timer_wheel_next_due(const struct timer_descriptor *const timer);
+#endif
+#else
 static void timer_add_timer_task(struct list_descriptor *list, struct timer_task *const new_task, const uint32_t time);
+#endif
+#if TIMER_TICKLESS_ENABLED
+static uint32_t timer_get_time(const struct timer_descriptor *const timer);
+static void     timer_schedule(struct timer_descriptor *const timer);
+#endif
 static void timer_process_counted(struct _timer_device *device);
 
 /**
@@ -70,6 +86,19 @@ int32_t timer_init(struct timer_descriptor *const descr, void *const hw, struct
 	_timer_init(&descr->device, hw);
 	descr->time                           = 0;
 	descr->device.timer_cb.period_expired = timer_process_counted;
+#if TIMER_TICKLESS_ENABLED
+	descr->cycles_per_tick  = _timer_get_period(&descr->device);
+	descr->ticks_per_period = 1;
+#endif
+#if TIMER_WHEEL_ENABLED
+	descr->wheel_time = 0;
+	for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		for (uint8_t slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+			list_reset(&descr->wheel[level][slot]);
+		}
+	}
+	list_reset(&descr->wheel_due);
+#endif
 
 	return ERR_NONE;
 }
@@ -119,7 +148,15 @@ int32_t timer_stop(struct timer_descriptor *const descr)
 int32_t timer_set_clock_cycles_per_tick(struct timer_descriptor *const descr, const uint32_t clock_cycles)
 {
 	ASSERT(descr);
+#if TIMER_TICKLESS_ENABLED
+	CRITICAL_SECTION_ENTER()
+	descr->cycles_per_tick  = clock_cycles;
+	descr->ticks_per_period = 1;
+	_timer_set_period(&descr->device, clock_cycles);
+	CRITICAL_SECTION_LEAVE()
+#else
 	_timer_set_period(&descr->device, clock_cycles);
+#endif
 
 	return ERR_NONE;
 }
@@ -132,13 +169,25 @@ int32_t timer_add_task(struct timer_descriptor *const descr, struct timer_task *
 	ASSERT(descr && task);
 
 	descr->flags |= TIMER_FLAG_QUEUE_IS_TAKEN;
+#if TIMER_WHEEL_ENABLED
+	if (timer_wheel_find_task(descr, task)) {
+#else
 	if (is_list_element(&descr->tasks, task)) {
+#endif
 		descr->flags &= ~TIMER_FLAG_QUEUE_IS_TAKEN;
 		ASSERT(false);
 		return ERR_ALREADY_INITIALIZED;
 	}
+#if TIMER_TICKLESS_ENABLED
+	task->time_label = timer_get_time(descr);
+#else
 	task->time_label = descr->time;
+#endif
+#if TIMER_WHEEL_ENABLED
+	timer_wheel_insert(descr, task, descr->wheel_time + 1);
+#else
 	timer_add_timer_task(&descr->tasks, task, descr->time);
+#endif
 
 	descr->flags &= ~TIMER_FLAG_QUEUE_IS_TAKEN;
 	if (descr->flags & TIMER_FLAG_INTERRUPT_TRIGERRED) {
@@ -147,6 +196,11 @@ int32_t timer_add_task(struct timer_descriptor *const descr, struct timer_task *
 		_timer_set_irq(&descr->device);
 		CRITICAL_SECTION_LEAVE()
 	}
+#if TIMER_TICKLESS_ENABLED
+	CRITICAL_SECTION_ENTER()
+	timer_schedule(descr);
+	CRITICAL_SECTION_LEAVE()
+#endif
 
 	return ERR_NONE;
 }
@@ -158,6 +212,18 @@ int32_t timer_remove_task(struct timer_descriptor *const descr, const struct tim
 {
 	ASSERT(descr && task);
 
+#if TIMER_WHEEL_ENABLED
+	struct list_descriptor *slot;
+
+	descr->flags |= TIMER_FLAG_QUEUE_IS_TAKEN;
+	slot = timer_wheel_find_task(descr, task);
+	if (!slot) {
+		descr->flags &= ~TIMER_FLAG_QUEUE_IS_TAKEN;
+		ASSERT(false);
+		return ERR_NOT_FOUND;
+	}
+	list_delete_element(slot, task);
+#else
 	descr->flags |= TIMER_FLAG_QUEUE_IS_TAKEN;
 	if (!is_list_element(&descr->tasks, task)) {
 		descr->flags &= ~TIMER_FLAG_QUEUE_IS_TAKEN;
@@ -165,6 +231,7 @@ int32_t timer_remove_task(struct timer_descriptor *const descr, const struct tim
 		return ERR_NOT_FOUND;
 	}
 	list_delete_element(&descr->tasks, task);
+#endif
 
 	descr->flags &= ~TIMER_FLAG_QUEUE_IS_TAKEN;
 	if (descr->flags & TIMER_FLAG_INTERRUPT_TRIGERRED) {
@@ -173,6 +240,11 @@ int32_t timer_remove_task(struct timer_descriptor *const descr, const struct tim
 		_timer_set_irq(&descr->device);
 		CRITICAL_SECTION_LEAVE()
 	}
+#if TIMER_TICKLESS_ENABLED
+	CRITICAL_SECTION_ENTER()
+	timer_schedule(descr);
+	CRITICAL_SECTION_LEAVE()
+#endif
 
 	return ERR_NONE;
 }
@@ -183,10 +255,27 @@ int32_t timer_remove_task(struct timer_descriptor *const descr, const struct tim
 int32_t timer_get_clock_cycles_in_tick(const struct timer_descriptor *const descr, uint32_t *const cycles)
 {
 	ASSERT(descr && cycles);
+#if TIMER_TICKLESS_ENABLED
+	*cycles = descr->cycles_per_tick;
+#else
 	*cycles = _timer_get_period(&descr->device);
+#endif
 	return ERR_NONE;
 }
 
+/**
+ * \brief Retrieve the current time
+ */
+uint32_t timer_get_ticks(const struct timer_descriptor *const descr)
+{
+	ASSERT(descr);
+#if TIMER_TICKLESS_ENABLED
+	return timer_get_time(descr);
+#else
+	return descr->time;
+#endif
+}
+
 /**
  * \brief Retrieve the current driver version
  */
@@ -195,6 +284,374 @@ uint32_t timer_get_version(void)
 	return DRIVER_VERSION;
 }
 
+#if TIMER_TICKLESS_ENABLED
+
+/**
+ * \brief Clock cycles to leave between the count and where a period is moved
+ * to end, for the write to synchronize
+ */
+#define TIMER_TICKLESS_MARGIN 16
+
+/**
+ * \internal Retrieve the current time, including ticks in the current period
+ *
+ * \param[in] timer The pointer to timer descriptor
+ *
+ * \return The current time in ticks
+ */
+static uint32_t timer_get_time(const struct timer_descriptor *const timer)
+{
+	uint32_t time;
+
+	CRITICAL_SECTION_ENTER()
+	/* The count first, so if the period has ended since, that's seen */
+	uint32_t count = _timer_get_counter(&timer->device);
+	if (_timer_is_period_expired(&timer->device)) {
+		time = timer->time + timer->ticks_per_period;
+	} else {
+		time = timer->time + count / (timer->cycles_per_tick + 1);
+	}
+	CRITICAL_SECTION_LEAVE()
+
+	return time;
+}
+
+/**
+ * \internal Retrieve the ticks from the given time until a task needs running
+ *
+ * \param[in] timer The pointer to timer descriptor
+ * \param[in] time The time now, in ticks
+ *
+ * \return Ticks to wait, at least 1, or UINT32_MAX if there are no tasks
+ */
+static uint32_t timer_ticks_to_next_task(const struct timer_descriptor *const timer, const uint32_t time)
+{
+	uint32_t due;
+
+#if TIMER_WHEEL_ENABLED
+	uint32_t ticks = timer_wheel_next_due(timer);
+
+	if (!ticks) {
+		return UINT32_MAX;
+	}
+	due = timer->wheel_time + ticks;
+#else
+	const struct timer_task *head = (const struct timer_task *)list_get_head(&timer->tasks);
+
+	if (!head) {
+		return UINT32_MAX;
+	}
+	due = head->time_label + head->interval;
+#endif
+
+	return (int32_t)(due - time) > 0 ? due - time : 1;
+}
+
+/**
+ * \internal Set the current period to end when the next task is due
+ *
+ * The period keeps counting from where it started, so it ends after a whole
+ * number of ticks.  Call from the timer interrupt, or with it masked.
+ *
+ * \param[in] timer The pointer to timer descriptor
+ */
+static void timer_schedule(struct timer_descriptor *const timer)
+{
+	const uint32_t per = timer->cycles_per_tick + 1;
+	uint32_t       count, elapsed, ticks, max_ticks;
+
+	if (!timer->cycles_per_tick) {
+		return;
+	}
+
+	count = _timer_get_counter(&timer->device);
+	/* About to end, or ended with the interrupt pending, which reschedules */
+	if (_timer_is_period_expired(&timer->device)
+	    || timer->ticks_per_period * per - 1 - count < TIMER_TICKLESS_MARGIN) {
+		return;
+	}
+
+	elapsed   = count / per;
+	max_ticks = _timer_get_max_period(&timer->device) / per;
+	ticks     = timer_ticks_to_next_task(timer, timer->time + elapsed);
+	ticks     = ticks > max_ticks - elapsed ? max_ticks : elapsed + ticks;
+
+	/* Don't move the end behind the count */
+	if (ticks * per - 1 - count < TIMER_TICKLESS_MARGIN) {
+		ticks++;
+	}
+
+	timer->ticks_per_period = ticks;
+	_timer_set_period(&timer->device, ticks * per - 1);
+}
+
+#endif /* TIMER_TICKLESS_ENABLED */
+
+#if TIMER_WHEEL_ENABLED
+
+/**
+ * \internal Find the wheel slot holding a timer task
+ *
+ * Only the slot the task was last put in is looked at, as that's the only one
+ * it can be in, or wheel_due if it's due this tick and yet to run.  The task's
+ * slot pointer is left as it was when the task expires or is removed, and
+ * isn't set up by the caller, so it's checked against the wheel and the slot's
+ * list rather than trusted.
+ *
+ * \param[in] timer The pointer to timer descriptor
+ * \param[in] task The pointer to task to look for
+ *
+ * \return The slot's list, or NULL if the task isn't on the wheel
+ */
+static struct list_descriptor *timer_wheel_find_task(struct timer_descriptor *const timer,
+                                                     const struct timer_task *const task)
+{
+	uintptr_t offset = (uintptr_t)task->slot - (uintptr_t)&timer->wheel[0][0];
+
+	if ((task->slot != &timer->wheel_due
+	     && (offset >= sizeof(timer->wheel) || offset % sizeof(struct list_descriptor)))
+	    || !is_list_element(task->slot, task)) {
+		return NULL;
+	}
+
+	return task->slot;
+}
+
+/**
+ * \internal Put a timer task in the wheel slot for when it's due
+ *
+ * A task due within TIMER_WHEEL_SLOTS ticks goes on level 0, in the slot for
+ * its tick.  Otherwise it goes on the lowest level whose slots still reach
+ * it, to be moved down when that slot comes round.  A slot the same distance
+ * round as the current one is next run a whole turn later, which is when a
+ * task up to a whole turn away is due.
+ *
+ * \param[in] timer The pointer to timer descriptor
+ * \param[in] task The pointer to task to add
+ * \param[in] next The first tick the wheel hasn't been run for yet
+ */
+static void timer_wheel_insert(struct timer_descriptor *const timer, struct timer_task *const task,
+                               const uint32_t next)
+{
+	uint32_t due   = task->time_label + task->interval;
+	uint32_t delta = due - next;
+	uint8_t  level = 0;
+
+	/* Overdue, or an interval of 0 */
+	if ((int32_t)delta < 0) {
+		due   = next;
+		delta = 0;
+	}
+
+	while (level < TIMER_WHEEL_LEVELS - 1 && (delta >> (TIMER_WHEEL_SLOT_BITS * (level + 1)))) {
+		level++;
+	}
+
+	/* Beyond the top level, wait in its furthest slot */
+	if (level == TIMER_WHEEL_LEVELS - 1 && (delta >> (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS))) {
+		due = next + (1ul << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1;
+	}
+
+	/* Not list_insert_as_head(), which checks the whole slot in debug builds */
+	struct list_descriptor *slot = &timer->wheel[level][(due >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1)];
+	task->elem.next              = slot->head;
+	slot->head                   = &task->elem;
+	task->slot                   = slot;
+}
+
+#if TIMER_TICKLESS_ENABLED
+/**
+ * \internal Find the first slot on a level with tasks in it
+ *
+ * \param[in] timer The pointer to timer descriptor
+ * \param[in] level The wheel level to look on
+ * \param[out] ticks Ticks after wheel_time that the slot is run
+ *
+ * \return The slot's list, or NULL if the level is empty
+ */
+static const struct list_descriptor *timer_wheel_first_slot(const struct timer_descriptor *const timer,
+                                                            const uint8_t level, uint32_t *const ticks)
+{
+	uint8_t  shift = TIMER_WHEEL_SLOT_BITS * level;
+	uint32_t step  = 1ul << shift;
+
+	/* Ticks to the next one that runs a slot on this level */
+	*ticks = step - (timer->wheel_time & (step - 1));
+
+	for (uint8_t i = 0; i < TIMER_WHEEL_SLOTS; i++, *ticks += step) {
+		const struct list_descriptor *slot
+		    = &timer->wheel[level][((timer->wheel_time + *ticks) >> shift) & (TIMER_WHEEL_SLOTS - 1)];
+
+		if (list_get_head(slot)) {
+			return slot;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * \internal Find the next tick the wheel has something to do
+ *
+ * That's the first tick with a task in its level 0 slot, or the first tick
+ * that moves a higher level slot with tasks in it down.  Ticks before it can
+ * be skipped.
+ *
+ * \param[in] timer The pointer to timer descriptor
+ *
+ * \return Ticks after wheel_time, or 0 if the wheel is empty
+ */
+static uint32_t timer_wheel_next_tick(const struct timer_descriptor *const timer)
+{
+	uint32_t next = 0, ticks;
+
+	for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		if (timer_wheel_first_slot(timer, level, &ticks) && (!next || ticks < next)) {
+			next = ticks;
+		}
+	}
+
+	return next;
+}
+
+/**
+ * \internal Find the next tick a task on the wheel is due
+ *
+ * A higher level slot is run before any of its tasks are due, so the task
+ * due first on a level is in its first slot with tasks in it.
+ *
+ * \param[in] timer The pointer to timer descriptor
+ *
+ * \return Ticks after wheel_time, or 0 if the wheel is empty
+ */
+static uint32_t timer_wheel_next_due(const struct timer_descriptor *const timer)
+{
+	uint32_t next = 0, ticks;
+
+	for (uint8_t level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		const struct list_descriptor *slot = timer_wheel_first_slot(timer, level, &ticks);
+		const struct timer_task *     it;
+
+		if (!slot) {
+			continue;
+		}
+		/* Level 0 slots are only for the one tick, higher ones hold tasks
+		 * due from when they're run on */
+		if (level) {
+			uint32_t first = UINT32_MAX;
+
+			for (it = (const struct timer_task *)list_get_head(slot); it;
+			     it = (const struct timer_task *)list_get_next_element(it)) {
+				first = min(first, it->time_label + it->interval - timer->wheel_time);
+			}
+			ticks = max(ticks, first);
+		}
+		if (!next || ticks < next) {
+			next = ticks;
+		}
+	}
+
+	return next;
+}
+
+#endif
+
+/**
+ * \internal Run the wheel for one tick
+ *
+ * \param[in] timer The pointer to timer descriptor
+ * \param[in] time The tick to run it for
+ */
+CONF_ISR_ATTR static void timer_wheel_tick(struct timer_descriptor *const timer, const uint32_t time)
+{
+	struct timer_task *it;
+
+	/* Move tasks down from the higher level slots that have come round,
+	 * highest first so none are missed on their way down */
+	for (uint8_t level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+		uint8_t shift = TIMER_WHEEL_SLOT_BITS * level;
+
+		if (time & ((1ul << shift) - 1)) {
+			continue;
+		}
+
+		struct list_descriptor *slot = &timer->wheel[level][(time >> shift) & (TIMER_WHEEL_SLOTS - 1)];
+		it                           = (struct timer_task *)list_get_head(slot);
+		list_reset(slot);
+		while (it) {
+			struct timer_task *tmp = it;
+
+			it = (struct timer_task *)list_get_next_element(it);
+			timer_wheel_insert(timer, tmp, time);
+		}
+	}
+
+	/* Everything in this tick's level 0 slot is due.  It's moved to wheel_due
+	 * first, as repeating tasks can be put back in the slot, and run from there
+	 * a task at a time, so a callback can still find the tasks yet to run, to
+	 * remove or add them. */
+	struct list_descriptor *slot = &timer->wheel[0][time & (TIMER_WHEEL_SLOTS - 1)];
+	timer->wheel_due.head        = slot->head;
+	list_reset(slot);
+	for (it = (struct timer_task *)list_get_head(&timer->wheel_due); it;
+	     it = (struct timer_task *)list_get_next_element(it)) {
+		it->slot = &timer->wheel_due;
+	}
+
+	while ((it = (struct timer_task *)list_remove_head(&timer->wheel_due))) {
+		if (TIMER_TASK_REPEAT == it->mode) {
+			it->time_label = time;
+			timer_wheel_insert(timer, it, time + 1);
+		}
+
+		it->cb(it);
+	}
+}
+
+/**
+ * \internal Process interrupts
+ */
+CONF_ISR_ATTR static void timer_process_counted(struct _timer_device *device)
+{
+	CONF_ISR_BENCH_BEGIN(TIMER_PROCESS);
+	struct timer_descriptor *timer = CONTAINER_OF(device, struct timer_descriptor, device);
+#if TIMER_TICKLESS_ENABLED
+	uint32_t time = timer->time += timer->ticks_per_period;
+#else
+	uint32_t time = ++timer->time;
+#endif
+
+	if ((timer->flags & TIMER_FLAG_QUEUE_IS_TAKEN) || (timer->flags & TIMER_FLAG_INTERRUPT_TRIGERRED)) {
+		timer->flags |= TIMER_FLAG_INTERRUPT_TRIGERRED;
+		CONF_ISR_BENCH_END(TIMER_PROCESS);
+		return;
+	}
+
+#if TIMER_TICKLESS_ENABLED
+	/* Catch up on all the ticks in the period, skipping those with nothing
+	 * to do, and any deferred while the tasks were being changed */
+	while (timer->wheel_time != time) {
+		uint32_t ticks = timer_wheel_next_tick(timer);
+
+		if (!ticks || ticks > time - timer->wheel_time) {
+			timer->wheel_time = time;
+			break;
+		}
+		timer->wheel_time += ticks;
+		timer_wheel_tick(timer, timer->wheel_time);
+	}
+	timer_schedule(timer);
+#else
+	/* Catch up on any ticks deferred while the tasks were being changed */
+	while (timer->wheel_time != time) {
+		timer_wheel_tick(timer, ++timer->wheel_time);
+	}
+#endif
+	CONF_ISR_BENCH_END(TIMER_PROCESS);
+}
+
+#else
+
 /**
  * \internal Insert a timer task into sorted timer's list
  *
@@ -234,14 +691,20 @@ static void timer_add_timer_task(struct list_descriptor *list, struct timer_task
 /**
  * \internal Process interrupts
  */
-static void timer_process_counted(struct _timer_device *device)
+CONF_ISR_ATTR static void timer_process_counted(struct _timer_device *device)
 {
+	CONF_ISR_BENCH_BEGIN(TIMER_PROCESS);
 	struct timer_descriptor *timer = CONTAINER_OF(device, struct timer_descriptor, device);
 	struct timer_task *      it    = (struct timer_task *)list_get_head(&timer->tasks);
-	uint32_t                 time  = ++timer->time;
+#if TIMER_TICKLESS_ENABLED
+	uint32_t time = timer->time += timer->ticks_per_period;
+#else
+	uint32_t time = ++timer->time;
+#endif
 
 	if ((timer->flags & TIMER_FLAG_QUEUE_IS_TAKEN) || (timer->flags & TIMER_FLAG_INTERRUPT_TRIGERRED)) {
 		timer->flags |= TIMER_FLAG_INTERRUPT_TRIGERRED;
+		CONF_ISR_BENCH_END(TIMER_PROCESS);
 		return;
 	}
 
@@ -253,8 +716,16 @@ static void timer_process_counted(struct _timer_device *device)
 			tmp->time_label = time;
 			timer_add_timer_task(&timer->tasks, tmp, time);
 		}
-		it = (struct timer_task *)list_get_head(&timer->tasks);
 
 		tmp->cb(tmp);
+
+		/* After the callback, which can add and remove tasks */
+		it = (struct timer_task *)list_get_head(&timer->tasks);
 	}
+#if TIMER_TICKLESS_ENABLED
+	timer_schedule(timer);
+#endif
+	CONF_ISR_BENCH_END(TIMER_PROCESS);
 }
+
+#endif /* TIMER_WHEEL_ENABLED */
@@ -118,6 +118,86 @@ uint32_t ringbuffer_num(const struct ringbuffer *const rb);
  */
 uint32_t ringbuffer_flush(struct ringbuffer *const rb);
 
+/**
+ * \brief Put one byte to ringbuffer, from its single producer
+ *
+ * The SPSC (single producer, single consumer) functions are safe without
+ * masking interrupts, as long as only one context ever writes and only one
+ * ever reads, eg an interrupt handler and the main loop.  Each side only
+ * updates its own index, and only after the data it covers, so unlike
+ * ringbuffer_put() a full buffer drops the new data rather than the oldest.
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[in] data one byte data to be put into ringbuffer
+ *
+ * \return ERR_NONE on success, or ERR_NO_RESOURCE if the buffer is full.
+ */
+int32_t ringbuffer_spsc_put(struct ringbuffer *const rb, uint8_t data);
+
+/**
+ * \brief Copy data into ringbuffer, from its single producer
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[in] data The data to be put into ringbuffer
+ * \param[in] length The number of bytes of data
+ *
+ * \return The number of bytes put, less than length if the buffer filled.
+ */
+uint32_t ringbuffer_spsc_write(struct ringbuffer *const rb, const uint8_t *data, uint32_t length);
+
+/**
+ * \brief Copy data out of ringbuffer, from its single consumer
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[out] data Space to store the read data
+ * \param[in] length The most bytes to read
+ *
+ * \return The number of bytes read.
+ */
+uint32_t ringbuffer_spsc_read(struct ringbuffer *const rb, uint8_t *data, uint32_t length);
+
+/**
+ * \brief Get the free space in ringbuffer that can be written in place
+ *
+ * The span stops at the end of the buffer memory, so there may be more free
+ * space after committing it.  Only for the single producer.
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[out] span The start of the free space
+ *
+ * \return The number of bytes that can be written at span.
+ */
+uint32_t ringbuffer_spsc_write_span(struct ringbuffer *const rb, uint8_t **span);
+
+/**
+ * \brief Hand bytes written in place over to the consumer
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[in] count The number of bytes written, at most the span length
+ */
+void ringbuffer_spsc_write_commit(struct ringbuffer *const rb, uint32_t count);
+
+/**
+ * \brief Get the data in ringbuffer that can be read in place
+ *
+ * The span stops at the end of the buffer memory, so there may be more data
+ * after committing it.  Only for the single consumer.
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[out] span The start of the data
+ *
+ * \return The number of bytes that can be read at span.
+ */
+uint32_t ringbuffer_spsc_read_span(struct ringbuffer *const rb, const uint8_t **span);
+
+/**
+ * \brief Free bytes read in place for the producer to reuse
+ *
+ * \param[in] rb The pointer to a ringbuffer structure instance
+ * \param[in] count The number of bytes read, at most the span length
+ */
+void ringbuffer_spsc_read_commit(struct ringbuffer *const rb, uint32_t count);
+
 /**@}*/
 
 #ifdef __cplusplus
@@ -41,6 +41,7 @@
  *
  */
 #include "utils_ringbuffer.h"
+#include <string.h>
 
 /**
  * \brief Ringbuffer init
@@ -126,3 +127,156 @@ uint32_t ringbuffer_flush(struct ringbuffer *const rb)
 
 	return ERR_NONE;
 }
+
+/*
+ * The SPSC functions read the other side's index through a volatile access,
+ * as an interrupt can move it at any time.  The barriers keep the data
+ * accesses on the right side of the index update: the producer fills bytes
+ * before publishing them, and the consumer is done with bytes before freeing
+ * them.  On the Cortex-M0+ the DMB is what stops the compiler reordering them.
+ */
+static inline uint32_t ringbuffer_load_index(const uint32_t *const index)
+{
+	return *(const volatile uint32_t *)index;
+}
+
+static inline void ringbuffer_store_index(uint32_t *const index, const uint32_t value)
+{
+	*(volatile uint32_t *)index = value;
+}
+
+/**
+ * \brief Get the free space in ringbuffer that can be written in place
+ */
+uint32_t ringbuffer_spsc_write_span(struct ringbuffer *const rb, uint8_t **span)
+{
+	uint32_t write_index, free, to_end;
+
+	ASSERT(rb && span);
+
+	write_index = rb->write_index;
+	free        = rb->size + 1 - (write_index - ringbuffer_load_index(&rb->read_index));
+	to_end      = rb->size + 1 - (write_index & rb->size);
+
+	/* Don't write over bytes until the consumer is done with them */
+	__DMB();
+
+	*span = &rb->buf[write_index & rb->size];
+	return free < to_end ? free : to_end;
+}
+
+/**
+ * \brief Hand bytes written in place over to the consumer
+ */
+void ringbuffer_spsc_write_commit(struct ringbuffer *const rb, uint32_t count)
+{
+	ASSERT(rb);
+
+	__DMB();
+	ringbuffer_store_index(&rb->write_index, rb->write_index + count);
+}
+
+/**
+ * \brief Get the data in ringbuffer that can be read in place
+ */
+uint32_t ringbuffer_spsc_read_span(struct ringbuffer *const rb, const uint8_t **span)
+{
+	uint32_t read_index, used, to_end;
+
+	ASSERT(rb && span);
+
+	read_index = rb->read_index;
+	used       = ringbuffer_load_index(&rb->write_index) - read_index;
+	to_end     = rb->size + 1 - (read_index & rb->size);
+
+	/* Don't read bytes before the producer has published them */
+	__DMB();
+
+	*span = &rb->buf[read_index & rb->size];
+	return used < to_end ? used : to_end;
+}
+
+/**
+ * \brief Free bytes read in place for the producer to reuse
+ */
+void ringbuffer_spsc_read_commit(struct ringbuffer *const rb, uint32_t count)
+{
+	ASSERT(rb);
+
+	__DMB();
+	ringbuffer_store_index(&rb->read_index, rb->read_index + count);
+}
+
+/**
+ * \brief Put one byte to ringbuffer, from its single producer
+ */
+int32_t ringbuffer_spsc_put(struct ringbuffer *const rb, uint8_t data)
+{
+	uint8_t *span;
+
+	if (!ringbuffer_spsc_write_span(rb, &span)) {
+		return ERR_NO_RESOURCE;
+	}
+
+	*span = data;
+	ringbuffer_spsc_write_commit(rb, 1);
+
+	return ERR_NONE;
+}
+
+/**
+ * \brief Copy data into ringbuffer, from its single producer
+ */
+uint32_t ringbuffer_spsc_write(struct ringbuffer *const rb, const uint8_t *data, uint32_t length)
+{
+	uint32_t written = 0;
+	uint8_t *span;
+
+	ASSERT(data || !length);
+
+	/* At most two spans, either side of the end of the buffer memory */
+	while (written < length) {
+		uint32_t count = ringbuffer_spsc_write_span(rb, &span);
+
+		if (!count) {
+			break;
+		}
+		if (count > length - written) {
+			count = length - written;
+		}
+
+		memcpy(span, &data[written], count);
+		ringbuffer_spsc_write_commit(rb, count);
+		written += count;
+	}
+
+	return written;
+}
+
+/**
+ * \brief Copy data out of ringbuffer, from its single consumer
+ */
+uint32_t ringbuffer_spsc_read(struct ringbuffer *const rb, uint8_t *data, uint32_t length)
+{
+	uint32_t       was_read = 0;
+	const uint8_t *span;
+
+	ASSERT(data || !length);
+
+	while (was_read < length) {
+		uint32_t count = ringbuffer_spsc_read_span(rb, &span);
+
+		if (!count) {
+			break;
+		}
+		if (count > length - was_read) {
+			count = length - was_read;
+		}
+
+		memcpy(&data[was_read], span, count);
+		ringbuffer_spsc_read_commit(rb, count);
+		was_read += count;
+	}
+
+	return was_read;
+}
@@ -0,0 +1,57 @@
+// Heartbeat LED driven from a TCC0 waveform output
+//
+#include "heartbeat.h"
+
+#include "pwm.h"
+
+// WARNING: This is shared with the reset pin, don't make it an output
+// until waiting a second to leave a window for re-programming
+#define HEARTBEAT_PIN PIN_PA30
+#define HEARTBEAT_PINMUX PINMUX_PA30F_TCC0_WO2
+
+// WO2 is driven by CC2 (WO[n] follows CC[n % 4] with the default OTMX)
+#define HEARTBEAT_CC 2
+
+#define HEARTRATE 3
+#define HEARTBEAT_MIN_BRIGHTNESS 1
+#define HEARTBEAT_MAX_BRIGHTNESS 100
+
+static bool heartbeat_enabled = false;
+
+void heartbeat_init(void)
+{
+    pwm_set_duty(HEARTBEAT_CC, PWM_PERIOD_TICKS - HEARTBEAT_MIN_BRIGHTNESS);
+}
+
+void heartbeat_enable(void)
+{
+    gpio_set_pin_function(HEARTBEAT_PIN, HEARTBEAT_PINMUX);
+    heartbeat_enabled = true;
+}
+
+void heartbeat_step(void)
+{
+    static int heartbeat_level = HEARTBEAT_MIN_BRIGHTNESS; // 0=off PWM_PERIOD_TICKS=full
+    static bool beat_direction = true;
+
+    if (!heartbeat_enabled) {
+        return;
+    }
+
+    if (beat_direction) {
+        heartbeat_level += HEARTRATE;
+        if (heartbeat_level > HEARTBEAT_MAX_BRIGHTNESS) {
+            beat_direction = false;
+            heartbeat_level = HEARTBEAT_MAX_BRIGHTNESS;
+        }
+    } else {
+        heartbeat_level -= HEARTRATE;
+        if (heartbeat_level < HEARTBEAT_MIN_BRIGHTNESS) {
+            beat_direction = true;
+            heartbeat_level = HEARTBEAT_MIN_BRIGHTNESS;
+        }
+    }
+
+    // Output is high until the CC match, but the LED is on when the pin is low
+    pwm_set_duty(HEARTBEAT_CC, PWM_PERIOD_TICKS - heartbeat_level);
+}
@@ -0,0 +1,28 @@
+// Heartbeat LED driven from a TCC0 waveform output
+//
+// The heartbeat used to be bit-banged from a TIMER_0 task, which needed a
+// timer interrupt every few tens of microseconds.  Now TCC0 generates the PWM
+// in hardware and the CPU only touches it to change the brightness.
+//
+#ifndef HEARTBEAT_H_INCLUDED
+#define HEARTBEAT_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// How often heartbeat_step() should be called, in milliseconds
+#define HEARTBEAT_STEP_MS 20
+
+/// Sets the heartbeat channel of TCC0, but leaves the heartbeat pin alone - see
+/// heartbeat_enable().  Call after pwm_init().
+void heartbeat_init(void);
+
+/// Hands the heartbeat pin over to TCC0
+///
+/// The heartbeat pin doubles as SWCLK, so this shouldn't be called until
+/// there's been a window to reprogram the board.
+void heartbeat_enable(void);
+
+/// Moves the breathing animation along by one step
+void heartbeat_step(void);
+
+#endif // HEARTBEAT_H_INCLUDED
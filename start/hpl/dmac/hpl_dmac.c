@@ -165,6 +165,13 @@ int32_t _dma_srcinc_enable(const uint8_t channel, const bool enable)
 	return ERR_NONE;
 }
 
+int32_t _dma_dstinc_enable(const uint8_t channel, const bool enable)
+{
+	hri_dmacdescriptor_write_BTCTRL_DSTINC_bit(&_descriptor_section[channel], enable);
+
+	return ERR_NONE;
+}
+
 int32_t _dma_set_data_amount(const uint8_t channel, const uint32_t amount)
 {
 	uint32_t address   = hri_dmacdescriptor_read_DSTADDR_reg(&_descriptor_section[channel]);
@@ -189,6 +196,8 @@ int32_t _dma_enable_transaction(const uint8_t channel, const bool software_trigg
 {
 	hri_dmac_write_CHID_reg(DMAC, channel);
 	hri_dmacdescriptor_set_BTCTRL_VALID_bit(&_descriptor_section[channel]);
+	/* The DMAC only writes back once it has fetched the descriptor */
+	_write_back_section[channel] = _descriptor_section[channel];
 	hri_dmac_set_CHCTRLA_ENABLE_bit(DMAC);
 	if (software_trigger) {
 		hri_dmac_set_SWTRIGCTRL_reg(DMAC, 1 << channel);
@@ -197,6 +206,21 @@ int32_t _dma_enable_transaction(const uint8_t channel, const bool software_trigg
 	return ERR_NONE;
 }
 
+int32_t _dma_disable_transaction(const uint8_t channel)
+{
+	hri_dmac_write_CHID_reg(DMAC, channel);
+	hri_dmac_clear_CHCTRLA_ENABLE_bit(DMAC);
+	while (hri_dmac_get_CHCTRLA_ENABLE_bit(DMAC)) {
+	}
+
+	return ERR_NONE;
+}
+
+uint32_t _dma_get_remaining_amount(const uint8_t channel)
+{
+	return hri_dmacdescriptor_read_BTCNT_reg(&_write_back_section[channel]);
+}
+
 int32_t _dma_get_channel_resource(struct _dma_resource **resource, const uint8_t channel)
 {
 	*resource = &_resources[channel];
@@ -52,6 +52,7 @@
 #include <hpl_spi_s_sync.h>
 #include <hpl_usart_async.h>
 #include <hpl_usart_sync.h>
+#include <isr_hooks_config.h>
 #include <utils.h>
 #include <utils_assert.h>
 
@@ -1891,17 +1892,25 @@ int32_t _i2c_s_async_set_irq_state(struct _i2c_s_async_device *const device, con
 		hri_sercomi2cs_write_INTEN_DRDY_bit(device->hw, state);
 	} else if (I2C_S_DEVICE_ERROR == type) {
 		hri_sercomi2cs_write_INTEN_ERROR_bit(device->hw, state);
+	} else if (I2C_S_DEVICE_STOP == type) {
+		hri_sercomi2cs_write_INTEN_PREC_bit(device->hw, state);
+	} else if (I2C_S_DEVICE_ADDRESS_MATCH == type) {
+		/* Automatic acknowledge doesn't raise address match */
+		hri_sercomi2cs_write_CTRLB_AACKEN_bit(device->hw, !state);
+		hri_sercomi2cs_write_INTEN_AMATCH_bit(device->hw, state);
 	}
 
 	return ERR_NONE;
 }
 
+/* Unless the application has its own handler for SERCOM0 */
+#if CONF_SERCOM_0_HPL_HANDLER
 /**
  * \internal Sercom i2c slave interrupt handler
  *
  * \param[in] p The pointer to i2c slave device
  */
-static void _sercom_i2c_s_irq_handler(struct _i2c_s_async_device *device)
+CONF_ISR_ATTR static void _sercom_i2c_s_irq_handler(struct _i2c_s_async_device *device)
 {
 	void *   hw    = device->hw;
 	uint32_t flags = hri_sercomi2cm_read_INTFLAG_reg(hw);
@@ -1909,10 +1918,31 @@ static void _sercom_i2c_s_irq_handler(struct _i2c_s_async_device *device)
 	if (flags & SERCOM_I2CS_INTFLAG_ERROR) {
 		ASSERT(device->cb.error);
 		device->cb.error(device);
+	} else if (flags & SERCOM_I2CS_INTFLAG_AMATCH) {
+		/* SCL is held until the ACK, so the callback can set up a read first */
+		ASSERT(device->cb.addr_match);
+		device->cb.addr_match(device);
+		hri_sercomi2cs_clear_CTRLB_ACKACT_bit(hw);
+		hri_sercomi2cs_write_CTRLB_CMD_bf(hw, 0x3);
 	} else if (flags & SERCOM_I2CS_INTFLAG_DRDY) {
 		if (!hri_sercomi2cs_get_STATUS_DIR_bit(hw)) {
-			ASSERT(device->cb.rx_done);
-			device->cb.rx_done(device, hri_sercomi2cs_read_DATA_reg(hw));
+			/* In smart mode, reading DATA answers the byte with ACKACT.  With
+			 * SCLSM the byte has already been answered, and ACKACT is for the
+			 * next one, so a NACK drops this byte and stops the one after. */
+			switch (device->cb.rx_ready ? device->cb.rx_ready(device) : I2C_S_RX_ACK) {
+			case I2C_S_RX_ACK:
+				hri_sercomi2cs_clear_CTRLB_ACKACT_bit(hw);
+				ASSERT(device->cb.rx_done);
+				device->cb.rx_done(device, hri_sercomi2cs_read_DATA_reg(hw));
+				break;
+			case I2C_S_RX_NACK:
+				hri_sercomi2cs_set_CTRLB_ACKACT_bit(hw);
+				hri_sercomi2cs_read_DATA_reg(hw);
+				break;
+			case I2C_S_RX_HOLD:
+				hri_sercomi2cs_clear_INTEN_DRDY_bit(hw);
+				break;
+			}
 		} else {
 			ASSERT(device->cb.tx);
 			device->cb.tx(device);
@@ -1924,7 +1954,19 @@ static void _sercom_i2c_s_irq_handler(struct _i2c_s_async_device *device)
 		hri_sercomi2cs_clear_STATUS_reg(hw, 0);
 #endif
 	}
+
+	if (flags & SERCOM_I2CS_INTFLAG_PREC) {
+		hri_sercomi2cs_clear_interrupt_PREC_bit(hw);
+#if CONF_SERCOM_0_I2CS_SCLSM
+		/* Don't leave a NACK for the first byte of the next transaction */
+		hri_sercomi2cs_clear_CTRLB_ACKACT_bit(hw);
+#endif
+		if (device->cb.stop) {
+			device->cb.stop(device);
+		}
+	}
 }
+#endif
 
 /**
  * \internal Initalize i2c slave hardware
@@ -2355,10 +2397,14 @@ static inline const struct sercomspi_regs_cfg *_spi_get_regs(const uint32_t hw_a
 	return NULL;
 }
 
-void SERCOM0_Handler(void)
+#if CONF_SERCOM_0_HPL_HANDLER
+CONF_ISR_ATTR void SERCOM0_Handler(void)
 {
+	CONF_ISR_BENCH_BEGIN(SERCOM0_HANDLER);
 	_sercom_i2c_s_irq_handler(_sercom0_dev);
+	CONF_ISR_BENCH_END(SERCOM0_HANDLER);
 }
+#endif
 
 int32_t _spi_m_sync_init(struct _spi_m_sync_dev *dev, void *const hw)
 {
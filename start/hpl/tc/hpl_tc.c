@@ -44,6 +44,7 @@
 #include <hpl_pwm.h>
 #include <hpl_tc_config.h>
 #include <hpl_timer.h>
+#include <isr_hooks_config.h>
 #include <utils.h>
 #include <utils_assert.h>
 #include <hpl_tc_base.h>
@@ -217,6 +218,47 @@ uint32_t _timer_get_period(const struct _timer_device *const device)
 
 	return 0;
 }
+/**
+ * \brief Retrieve the largest timer period
+ */
+uint32_t _timer_get_max_period(const struct _timer_device *const device)
+{
+	void *const hw = device->hw;
+
+	if (TC_CTRLA_MODE_COUNT32_Val == hri_tc_read_CTRLA_MODE_bf(hw)) {
+		return UINT32_MAX;
+	} else if (TC_CTRLA_MODE_COUNT16_Val == hri_tc_read_CTRLA_MODE_bf(hw)) {
+		return UINT16_MAX;
+	}
+
+	return UINT8_MAX;
+}
+/**
+ * \brief Retrieve timer counter value
+ */
+uint32_t _timer_get_counter(const struct _timer_device *const device)
+{
+	void *const hw = device->hw;
+
+	/* COUNT is in the TC clock domain, so has to be synchronized to read */
+	hri_tc_write_READREQ_reg(hw, TC_READREQ_RREQ | TC_READREQ_ADDR(TC_COUNT32_COUNT_OFFSET));
+	hri_tc_wait_for_sync(hw);
+
+	if (TC_CTRLA_MODE_COUNT32_Val == hri_tc_read_CTRLA_MODE_bf(hw)) {
+		return hri_tccount32_read_COUNT_reg(hw);
+	} else if (TC_CTRLA_MODE_COUNT16_Val == hri_tc_read_CTRLA_MODE_bf(hw)) {
+		return hri_tccount16_read_COUNT_reg(hw);
+	}
+
+	return hri_tccount8_read_COUNT_reg(hw);
+}
+/**
+ * \brief Check if the period has expired, with the interrupt not yet taken
+ */
+bool _timer_is_period_expired(const struct _timer_device *const device)
+{
+	return hri_tc_get_interrupt_OVF_bit(device->hw);
+}
 /**
  * \brief Check if timer is running
  */
@@ -254,7 +296,7 @@ void _timer_set_irq(struct _timer_device *const device)
  *
  * \param[in] instance TC instance number
  */
-static void tc_interrupt_handler(struct _timer_device *device)
+CONF_ISR_ATTR static void tc_interrupt_handler(struct _timer_device *device)
 {
 	void *const hw = device->hw;
 
@@ -267,9 +309,11 @@ static void tc_interrupt_handler(struct _timer_device *device)
 /**
 * \brief TC interrupt handler
 */
-void TC1_Handler(void)
+CONF_ISR_ATTR void TC1_Handler(void)
 {
+	CONF_ISR_BENCH_BEGIN(TC1_HANDLER);
 	tc_interrupt_handler(_tc1_dev);
+	CONF_ISR_BENCH_END(TC1_HANDLER);
 }
 
 /**
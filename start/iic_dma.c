@@ -0,0 +1,147 @@
+// DMA for the data bytes of the IIC slave
+//
+#include "iic_dma.h"
+
+#include <hpl_dma.h>
+
+/// Largest block the DMAC does, for dropping or padding bytes without end
+#define DMA_BLOCK_MAX UINT16_MAX
+
+/// Set once a frame has filled its buffer, and any more of it is being dropped
+static volatile bool rx_overflowed = false;
+
+/// Set once a byte past the end of the buffer has arrived and been dropped
+static volatile bool rx_dropped = false;
+static uint8_t rx_discard;
+
+static const uint8_t tx_filler = 0xFF;
+
+static void rx_start(uint8_t *buffer, uint16_t length, bool increment)
+{
+    _dma_set_source_address(IIC_DMA_RX_CHANNEL, (const void *)&SERCOM0->I2CS.DATA.reg);
+    _dma_set_destination_address(IIC_DMA_RX_CHANNEL, buffer);
+    _dma_dstinc_enable(IIC_DMA_RX_CHANNEL, increment);
+    _dma_set_data_amount(IIC_DMA_RX_CHANNEL, length);
+    _dma_enable_transaction(IIC_DMA_RX_CHANNEL, false);
+}
+
+static void tx_start(const uint8_t *data, uint16_t length, bool increment)
+{
+    _dma_set_source_address(IIC_DMA_TX_CHANNEL, data);
+    _dma_set_destination_address(IIC_DMA_TX_CHANNEL, (const void *)&SERCOM0->I2CS.DATA.reg);
+    _dma_srcinc_enable(IIC_DMA_TX_CHANNEL, increment);
+    _dma_set_data_amount(IIC_DMA_TX_CHANNEL, length);
+    _dma_enable_transaction(IIC_DMA_TX_CHANNEL, false);
+}
+
+/// Starts receiving into the frame at the head of the queue
+static void rx_rewind(void)
+{
+    _dma_disable_transaction(IIC_DMA_RX_CHANNEL);
+    rx_overflowed = false;
+    rx_dropped = false;
+    rx_start(iic_frames_receiving(), IIC_FRAME_SIZE, true);
+}
+
+/// Starts sending from the first byte of the TX data
+static void tx_rewind(void)
+{
+    uint8_t length;
+    const uint8_t *data = iic_frames_tx_rewind(&length);
+
+    _dma_disable_transaction(IIC_DMA_TX_CHANNEL);
+    if (length) {
+        tx_start(data, length, true);
+    } else {
+        tx_start(&tx_filler, DMA_BLOCK_MAX, false);
+    }
+}
+
+/// The frame has filled its buffer, so NACK and drop anything more of it
+///
+/// The NACK tells the master to stop.  The stop, or failing that the next
+/// address match, acknowledges again, clearing ACKACT.  With SCLSM, the next
+/// byte is answered as it arrives, so at Fast-mode Plus the NACK may only
+/// catch the byte after; either way the frame stops at its buffer.
+///
+/// A frame of exactly IIC_FRAME_SIZE bytes fills the buffer too, so the first
+/// byte dropped has a transfer of its own, and only that counts the frame as
+/// cut short.  The stop can't tell from the remaining count: the DMAC only
+/// writes it back once a transfer has started.
+static void rx_full(struct _dma_resource *resource)
+{
+    if (!rx_overflowed) {
+        hri_sercomi2cs_set_CTRLB_ACKACT_bit(SERCOM0);
+        rx_overflowed = true;
+        rx_start(&rx_discard, 1, false);
+        return;
+    }
+
+    if (!rx_dropped) {
+        rx_dropped = true;
+        ++iic_frame_counts.rx_nacks;
+    }
+    rx_start(&rx_discard, DMA_BLOCK_MAX, false);
+}
+
+/// The master has read all there is, so pad the rest of the read
+static void tx_empty(struct _dma_resource *resource)
+{
+    tx_start(&tx_filler, DMA_BLOCK_MAX, false);
+}
+
+// Transfer errors only come from bad descriptors, but start over if one does
+static void rx_error(struct _dma_resource *resource)
+{
+    rx_rewind();
+}
+
+static void tx_error(struct _dma_resource *resource)
+{
+    tx_rewind();
+}
+
+void iic_dma_init(void)
+{
+    struct _dma_resource *resource;
+
+    _dma_get_channel_resource(&resource, IIC_DMA_RX_CHANNEL);
+    resource->dma_cb.transfer_done = rx_full;
+    resource->dma_cb.error = rx_error;
+    _dma_set_irq_state(IIC_DMA_RX_CHANNEL, DMA_TRANSFER_COMPLETE_CB, true);
+    _dma_set_irq_state(IIC_DMA_RX_CHANNEL, DMA_TRANSFER_ERROR_CB, true);
+
+    _dma_get_channel_resource(&resource, IIC_DMA_TX_CHANNEL);
+    resource->dma_cb.transfer_done = tx_empty;
+    resource->dma_cb.error = tx_error;
+    _dma_set_irq_state(IIC_DMA_TX_CHANNEL, DMA_TRANSFER_COMPLETE_CB, true);
+    _dma_set_irq_state(IIC_DMA_TX_CHANNEL, DMA_TRANSFER_ERROR_CB, true);
+
+    rx_rewind();
+    tx_rewind();
+}
+
+bool iic_dma_stop(void)
+{
+    uint8_t length;
+    bool received;
+
+    // DMAC_IRQn outranks SERCOM0_IRQn, so if the last byte filled the buffer
+    // rx_full() has run by now
+    _dma_disable_transaction(IIC_DMA_RX_CHANNEL);
+    if (rx_overflowed) {
+        hri_sercomi2cs_clear_CTRLB_ACKACT_bit(SERCOM0);
+        length = IIC_FRAME_SIZE;
+    } else {
+        length = IIC_FRAME_SIZE - _dma_get_remaining_amount(IIC_DMA_RX_CHANNEL);
+    }
+
+    received = iic_frames_end(length);
+    rx_rewind();
+    return received;
+}
+
+void iic_dma_address_match(void)
+{
+    tx_rewind();
+}
@@ -0,0 +1,53 @@
+// DMA for the data bytes of the IIC slave
+//
+// Without DMA, every byte in or out of I2C_0 takes a SERCOM0 interrupt.  With
+// it, one DMAC channel copies the bytes of each write into a frame buffer,
+// and another feeds a master's reads from memory.  SERCOM0 then only
+// interrupts twice per transaction, however long it is: once on the address
+// match, and once on the stop condition.
+//
+// The DMAC stops along with the AHB clock in standby, so it can only move
+// bytes while the CPU sleeps in IDLE0.  The address match interrupt is what
+// lets the main loop know to sleep lightly until the stop.
+//
+#ifndef IIC_DMA_H_INCLUDED
+#define IIC_DMA_H_INCLUDED
+
+#include <atmel_start.h>
+
+#include "iic_fast.h"
+#include "iic_frames.h"
+
+/// Build with -DIIC_DMA_ENABLED=0 for the interrupt per byte I2C_0 path.  The
+/// fast path takes the place of this one, see iic_fast.h.
+#ifndef IIC_DMA_ENABLED
+#define IIC_DMA_ENABLED !IIC_FAST_ENABLED
+#endif
+
+#if IIC_DMA_ENABLED && IIC_FAST_ENABLED
+#error "Only one of the DMA and fast I2C_0 paths can be built"
+#endif
+
+// Channels as set up in hpl_dmac_config.h
+#define IIC_DMA_RX_CHANNEL 0
+#define IIC_DMA_TX_CHANNEL 1
+
+/// Starts DMA for I2C_0's data bytes.  Call before enabling I2C_0, and don't
+/// register RX or TX callbacks for it - they'd take the bytes first.
+void iic_dma_init(void);
+
+/// Ends the frame received since the last stop, and starts the next
+///
+/// Call from the I2C_0 stop callback.  Returns true if there's a new frame
+/// for iic_frames_next(), false for a master read, an empty write, or if
+/// all the frame buffers were full.
+bool iic_dma_stop(void);
+
+/// Starts the TX data over from its first byte, for a read
+///
+/// Call from the I2C_0 address match callback, before the address is
+/// acknowledged, so the first byte of a read is the one it sends.  A write's
+/// address match does this too, harmlessly.
+void iic_dma_address_match(void);
+
+#endif // IIC_DMA_H_INCLUDED
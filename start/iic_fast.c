@@ -0,0 +1,122 @@
+// Fast path I2C slave, with its own SERCOM0 handler
+//
+#include "iic_fast.h"
+
+#include <hpl_sercom_config.h>
+
+#include "bench.h"
+#include "ramfunc.h"
+
+#if IIC_FAST_ENABLED
+
+/// Frame buffer being received into, and how much of it has been
+static uint8_t *rx_frame;
+static uint8_t rx_length = 0;
+
+/// Set once a frame has filled its buffer, and the rest is being NACKed
+static bool rx_overflowed = false;
+
+/// Set once ACKACT is set, for the NACK to be undone at the end of the
+/// transaction
+static bool rx_nacking = false;
+
+/// The TX data as of the first byte of the current or last read, and how far
+/// the read has got.  The stop condition rewinds it for the next read.
+static const uint8_t *tx_source = NULL;
+static uint8_t tx_source_length = 0;
+static uint8_t tx_position = 0;
+
+/// CTRLB as ASF set it up, with no command and ACKACT clear, so the handler
+/// can write it in one go
+static uint32_t ctrlb;
+
+void iic_fast_init(void)
+{
+    ctrlb = SERCOM0->I2CS.CTRLB.reg & ~(SERCOM_I2CS_CTRLB_CMD_Msk | SERCOM_I2CS_CTRLB_ACKACT);
+    rx_frame = iic_frames_receiving();
+
+    // ASF leaves AACKEN set until an address match callback is registered, so
+    // SERCOM0 acknowledges the address itself, without an interrupt
+    SERCOM0->I2CS.INTENSET.reg = SERCOM_I2CS_INTENSET_DRDY | SERCOM_I2CS_INTENSET_PREC | SERCOM_I2CS_INTENSET_ERROR;
+}
+
+/// Ends the transaction, queueing the frame received in it, and gets ready for
+/// the next
+static inline void transaction_end(void)
+{
+    if (iic_frames_end(rx_length)) {
+        rx_frame = iic_frames_receiving();
+        iic_fast_frame_received();
+    }
+
+    // ACK again, after any NACK
+    if (rx_nacking) {
+        SERCOM0->I2CS.CTRLB.reg = ctrlb;
+        rx_nacking = false;
+    }
+    rx_overflowed = false;
+
+    rx_length = 0;
+    tx_position = 0;
+}
+
+HOT_RAMFUNC void SERCOM0_Handler(void)
+{
+    BENCH_BEGIN(BENCH_SERCOM0_HANDLER);
+    SercomI2cs *const i2cs = &SERCOM0->I2CS;
+    const uint8_t flags = i2cs->INTFLAG.reg;
+
+    if (flags & SERCOM_I2CS_INTFLAG_DRDY) {
+        if (i2cs->STATUS.reg & SERCOM_I2CS_STATUS_DIR) {
+            if (!tx_position) {
+                tx_source = iic_frames_tx_rewind(&tx_source_length);
+            }
+
+            // Writing the byte to send releases SCL
+            if (tx_position < tx_source_length) {
+                i2cs->DATA.reg = tx_source[tx_position++];
+            } else {
+                i2cs->DATA.reg = 0xFF;
+            }
+        } else if (rx_length < IIC_FRAME_SIZE) {
+#if CONF_SERCOM_0_I2CS_SCLSM
+            // This byte has been ACKed already, and ACKACT answers the next,
+            // so NACK the one that won't fit before letting it come
+            if (rx_length == IIC_FRAME_SIZE - 1) {
+                i2cs->CTRLB.reg = ctrlb | SERCOM_I2CS_CTRLB_ACKACT;
+                rx_nacking = true;
+            }
+#endif
+            // Smart mode ACKs the byte as it's read, or with SCLSM already
+            // has, ACKACT being clear
+            rx_frame[rx_length++] = i2cs->DATA.reg;
+        } else {
+            // The frame has filled its buffer, so NACK it, which tells the
+            // master to stop
+            i2cs->CTRLB.reg = ctrlb | SERCOM_I2CS_CTRLB_ACKACT;
+            rx_nacking = true;
+            (void)i2cs->DATA.reg;
+            if (!rx_overflowed) {
+                rx_overflowed = true;
+                ++iic_frame_counts.rx_nacks;
+            }
+        }
+    } else if (flags & SERCOM_I2CS_INTFLAG_ERROR) {
+        // SERCOM0 drops the transaction by itself, and there may be no stop
+        // condition, so end it here without the frame
+        i2cs->STATUS.reg = SERCOM_I2CS_STATUS_BUSERR | SERCOM_I2CS_STATUS_COLL | SERCOM_I2CS_STATUS_LOWTOUT |
+                           SERCOM_I2CS_STATUS_SEXTTOUT;
+        i2cs->INTFLAG.reg = SERCOM_I2CS_INTFLAG_ERROR;
+        ++iic_frame_counts.bus_errors;
+        rx_length = 0;
+        transaction_end();
+    }
+
+    if (flags & SERCOM_I2CS_INTFLAG_PREC) {
+        i2cs->INTFLAG.reg = SERCOM_I2CS_INTFLAG_PREC;
+        transaction_end();
+    }
+    BENCH_END(BENCH_SERCOM0_HANDLER);
+}
+
+#endif // IIC_FAST_ENABLED
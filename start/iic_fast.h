@@ -0,0 +1,51 @@
+// Fast path I2C slave, with its own SERCOM0 handler
+//
+// Through ASF, each byte received goes from SERCOM0_Handler through the HPL's
+// handler, a callback into the HAL, its ring buffer with its ASSERTs, and the
+// HAL's own callbacks - several calls through pointers, each fetched from
+// flash with a wait state.  This driver replaces all of that with one
+// handler, which moves each byte between SERCOM0's DATA register and a frame
+// buffer itself, queueing the frames with iic_frames.h like the DMA path.
+//
+// It still takes an interrupt per byte, like the per byte path, but each one
+// is short.  Unlike the DMA path, it doesn't need the AHB clock between
+// bytes, so the CPU can go on sleeping in standby during a transaction.
+// make bench in sim/ compares the work each path's handlers do, and
+// bench_stats.probes[BENCH_SERCOM0_HANDLER] how long they take on a board.
+//
+// ASF still sets SERCOM0 up, from I2C_0's configuration, and this takes over
+// from there.  Build with -DCONF_SERCOM_0_HPL_HANDLER=0, or set it in
+// hpl_sercom_config.h, to leave hpl_sercom.c's SERCOM0_Handler out and use
+// this one instead of the DMA path.
+//
+#ifndef IIC_FAST_H_INCLUDED
+#define IIC_FAST_H_INCLUDED
+
+#include <atmel_start.h>
+#include <hpl_sercom_config.h>
+
+#include "iic_frames.h"
+
+/// Built when hpl_sercom.c leaves SERCOM0_Handler to the application
+#ifndef IIC_FAST_ENABLED
+#define IIC_FAST_ENABLED !CONF_SERCOM_0_HPL_HANDLER
+#endif
+
+#if IIC_FAST_ENABLED && CONF_SERCOM_0_HPL_HANDLER
+#error "The fast path needs CONF_SERCOM_0_HPL_HANDLER set to 0"
+#endif
+
+#if !IIC_FAST_ENABLED && !CONF_SERCOM_0_HPL_HANDLER
+#error "Nothing handles SERCOM0's interrupt"
+#endif
+
+/// Enables SERCOM0's interrupts for the fast path.  Call after I2C_0 is
+/// initialised, and don't register any callbacks for I2C_0 - they're never
+/// called.
+void iic_fast_init(void);
+
+/// Defined by the application, and called from SERCOM0_Handler each time a
+/// frame is queued for iic_frames_next()
+void iic_fast_frame_received(void);
+
+#endif // IIC_FAST_H_INCLUDED
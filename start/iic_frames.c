@@ -0,0 +1,81 @@
+// Received frames, read data and counts for the DMA and fast I2C slave paths
+//
+#include "iic_frames.h"
+
+static uint8_t frames[IIC_FRAMES][IIC_FRAME_SIZE];
+static volatile uint8_t frame_lengths[IIC_FRAMES];
+
+/// Frame being received into
+static volatile uint8_t frame_head = 0;
+
+/// Oldest frame waiting for the main loop
+static volatile uint8_t frame_tail = 0;
+
+volatile struct iic_frame_counts iic_frame_counts;
+
+static const uint8_t *volatile tx_data = NULL;
+static volatile uint8_t tx_length = 0;
+
+/// tx_data as of the last rewind, what the current or last read sends
+static const uint8_t *volatile tx_source = NULL;
+
+uint8_t *iic_frames_receiving(void)
+{
+    return frames[frame_head];
+}
+
+bool iic_frames_end(uint8_t length)
+{
+    uint8_t next = (frame_head + 1) % IIC_FRAMES;
+
+    if (!length) {
+        return false;
+    }
+    iic_frame_counts.rx_bytes += length;
+
+    if (next == frame_tail) {
+        ++iic_frame_counts.frames_dropped;
+        return false;
+    }
+
+    frame_lengths[frame_head] = length;
+    frame_head = next;
+    ++iic_frame_counts.rx_frames;
+    return true;
+}
+
+bool iic_frames_next(const uint8_t **frame, uint8_t *length)
+{
+    if (frame_tail == frame_head) {
+        return false;
+    }
+
+    *frame = frames[frame_tail];
+    *length = frame_lengths[frame_tail];
+    return true;
+}
+
+void iic_frames_release(void)
+{
+    frame_tail = (frame_tail + 1) % IIC_FRAMES;
+}
+
+void iic_frames_set_tx(const uint8_t *data, uint8_t length)
+{
+    CRITICAL_SECTION_ENTER()
+    tx_data = data;
+    tx_length = length;
+    CRITICAL_SECTION_LEAVE()
+}
+
+const uint8_t *iic_frames_tx_rewind(uint8_t *length)
+{
+    tx_source = tx_data;
+    *length = tx_length;
+    return tx_source;
+}
+
+const uint8_t *iic_frames_get_tx_source(void)
+{
+    return tx_source;
+}
@@ -0,0 +1,60 @@
+// Received frames, read data and counts for the DMA and fast I2C slave paths
+//
+// Both paths receive each write into a frame buffer of its own, and queue it
+// at the stop condition for the main loop, which handles it in place and
+// then hands the buffer back.  One buffer is always being received into, so
+// the queue holds one less frame than there are buffers.  A frame arriving
+// with every buffer full is dropped by receiving over it.
+//
+// What a master reads is set with iic_frames_set_tx(), and taken up by the
+// path at the start of each read.
+//
+#ifndef IIC_FRAMES_H_INCLUDED
+#define IIC_FRAMES_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// Longer frames have their extra bytes NACKed, like the per byte path
+#define IIC_FRAME_SIZE SERCOM0_I2CS_BUFFER_SIZE
+
+#define IIC_FRAMES 4
+
+/// I2C_0 counts since reset, kept by the path in use
+struct iic_frame_counts {
+    uint32_t rx_bytes;       // Received, in frames kept or dropped, up to any NACK
+    uint32_t rx_frames;      // Frames queued for iic_frames_next()
+    uint32_t rx_nacks;       // Frames with a byte past their buffer, cut short with a NACK, once each
+    uint32_t frames_dropped; // Frames that arrived with every frame buffer full
+    uint32_t bus_errors;     // SERCOM0 errors, eg bus errors and SCL timeouts, on any path
+};
+
+extern volatile struct iic_frame_counts iic_frame_counts;
+
+/// The frame buffer being received into, IIC_FRAME_SIZE bytes
+uint8_t *iic_frames_receiving(void);
+
+/// Ends the frame being received, length bytes long, queueing it unless it's
+/// empty or there's no buffer free.  Returns true if it was queued, in which
+/// case iic_frames_receiving() has moved on to the next buffer.
+bool iic_frames_end(uint8_t length);
+
+/// Gets the oldest received frame, which stays put until
+/// iic_frames_release().  Returns false if there isn't one.
+bool iic_frames_next(const uint8_t **frame, uint8_t *length);
+
+/// Hands the frame from iic_frames_next() back for receiving into
+void iic_frames_release(void);
+
+/// Sets what a master reads, from the next read on.  Each read starts over
+/// from the first byte, and gets 0xFF past the end.  data must stay put, and
+/// unchanged while it's iic_frames_get_tx_source().
+void iic_frames_set_tx(const uint8_t *data, uint8_t length);
+
+/// Takes up the data from iic_frames_set_tx() for a read starting, and
+/// returns it with its length
+const uint8_t *iic_frames_tx_rewind(uint8_t *length);
+
+/// The TX data the current read is sending, or the last read sent
+const uint8_t *iic_frames_get_tx_source(void);
+
+#endif // IIC_FRAMES_H_INCLUDED
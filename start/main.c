@@ -4,15 +4,16 @@
 //
 #include <atmel_start.h>
 
-// Segments are encoded as seen from font:
-//
-//  --E--
-// |     |
-// C     G
-// |--D--|
-// B     F
-// |     |
-//  --A--
+#include "bench.h"
+#include "clock_profile.h"
+#include "display.h"
+#include "heartbeat.h"
+#include "iic_dma.h"
+#include "iic_fast.h"
+#include "iic_frames.h"
+#include "protocol.h"
+#include "pwm.h"
+#include "telemetry.h"
 
 // The IIC slave address is determined by the state of the ADDR jumpers:
 // address = IIC_BASE_ADDRESS + offset
@@ -28,138 +29,10 @@
 //    7   | Jumped | Jumped | Jumped 
 #define IIC_BASE_ADDRESS 0x10
 
-/// These need to be representable with 8-bits
-enum IIC_command_enum {
-    ZERO,
-    ONE,
-    TWO,
-    THREE,
-    FOUR,
-    FIVE,
-    SIX,
-    SEVEN,
-    EIGHT,
-    NINE,
-
-    IIC_COMMAND_OFF = 0xFF
-};
-
-// WARNING: This is shared with the reset pin, don't make it an output
-// until waiting a second to leave a window for re-programming
-#define HEARTBEAT_PIN PIN_PA30
-
-#define SEGMENT_A_PIN PIN_PA25
-#define SEGMENT_B_PIN PIN_PA24
-#define SEGMENT_C_PIN PIN_PA02
-#define SEGMENT_D_PIN PIN_PA04
-#define SEGMENT_E_PIN PIN_PA05
-#define SEGMENT_F_PIN PIN_PA08
-#define SEGMENT_G_PIN PIN_PA09
-
-#define SEGMENT_A_MASK 0x01
-#define SEGMENT_B_MASK 0x02
-#define SEGMENT_C_MASK 0x04
-#define SEGMENT_D_MASK 0x08
-#define SEGMENT_E_MASK 0x10
-#define SEGMENT_F_MASK 0x20
-#define SEGMENT_G_MASK 0x40
-
-void show_digit(enum IIC_command_enum value)
-{
-    uint8_t led_mask;
-
-    switch(value) {
-        case ZERO:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_B_MASK |
-                       SEGMENT_C_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case ONE:
-            led_mask = SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case TWO:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_B_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case THREE:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case FOUR:
-            led_mask = SEGMENT_C_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case FIVE:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_C_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK;
-            break;
-
-        case SIX:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_B_MASK |
-                       SEGMENT_C_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK;
-            break;
-
-        case SEVEN:
-            led_mask = SEGMENT_E_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case EIGHT:
-            led_mask = SEGMENT_A_MASK |
-                       SEGMENT_B_MASK |
-                       SEGMENT_C_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        case NINE:
-            led_mask = SEGMENT_C_MASK |
-                       SEGMENT_D_MASK |
-                       SEGMENT_E_MASK |
-                       SEGMENT_F_MASK |
-                       SEGMENT_G_MASK;
-            break;
-
-        default:
-            led_mask = 0;
-            break;
-    }
-
-    gpio_set_pin_level(SEGMENT_A_PIN, led_mask & SEGMENT_A_MASK);
-    gpio_set_pin_level(SEGMENT_B_PIN, led_mask & SEGMENT_B_MASK);
-    gpio_set_pin_level(SEGMENT_C_PIN, led_mask & SEGMENT_C_MASK);
-    gpio_set_pin_level(SEGMENT_D_PIN, led_mask & SEGMENT_D_MASK);
-    gpio_set_pin_level(SEGMENT_E_PIN, led_mask & SEGMENT_E_MASK);
-    gpio_set_pin_level(SEGMENT_F_PIN, led_mask & SEGMENT_F_MASK);
-    gpio_set_pin_level(SEGMENT_G_PIN, led_mask & SEGMENT_G_MASK);
-}
+// TC1 runs at 8MHz / 8 = 1MHz, from OSC8M through GCLK1 whatever the CPU
+// clock, so this makes TIMER_0 tick every millisecond.
+// TC1 counts from 0 up to this and then wraps, so a tick is one more cycle.
+#define TIMER_0_CYCLES_PER_TICK 999
 
 /// Twiddles GPIO pins to figure out what our IIC address is set to
 uint8_t get_address(void)
@@ -197,133 +70,447 @@ uint8_t get_address(void)
     return IIC_BASE_ADDRESS + offset;
 }
 
+#if !IIC_FAST_ENABLED // The fast path handles its own errors
+
+/// Counts a bus error or SCL timeout, and clears it
+///
+/// The HPL leaves the error flags alone, so they'd interrupt again straight
+/// away.  SERCOM0 drops the transaction by itself.
 static void I2C_0_error(const struct i2c_s_async_descriptor *const descr)
 {
-    REG_SERCOM1_I2CS_INTENCLR = (1 << 7);
+    hri_sercomi2cs_clear_STATUS_reg(SERCOM0, SERCOM_I2CS_STATUS_BUSERR | SERCOM_I2CS_STATUS_COLL |
+                                             SERCOM_I2CS_STATUS_LOWTOUT | SERCOM_I2CS_STATUS_SEXTTOUT);
+    hri_sercomi2cs_clear_interrupt_ERROR_bit(SERCOM0);
+    ++iic_frame_counts.bus_errors;
+}
+
+#endif // !IIC_FAST_ENABLED
+
+/// Set by the I2C stop callback to wake up the main loop
+static volatile bool iic_rx_pending = false;
+
+/// Cycle counter value when iic_rx_pending was set
+static volatile uint32_t iic_rx_timestamp;
+
+/// Tells the main loop to wake up and handle what's been received, boosting
+/// the CPU to handle it sooner
+static void iic_frame_received(void)
+{
+    clock_profile_boost();
+
+    if (!iic_rx_pending) {
+        iic_rx_timestamp = cycle_counter_read();
+        iic_rx_pending = true;
+    }
+}
+
+#if IIC_FAST_ENABLED
+
+void iic_fast_frame_received(void)
+{
+    iic_frame_received();
+}
+
+/// Setup the fast path I2C slave, which takes over from ASF once it's set up
+void setup_iic(uint8_t address)
+{
+    iic_fast_init();
+
+    i2c_s_async_set_addr(&I2C_0, address);
+    i2c_s_async_enable(&I2C_0);
+}
+
+#elif IIC_DMA_ENABLED
+
+/// Set between an address match and the stop, while DMA is moving bytes
+static volatile bool iic_transaction_active = false;
+
+static void I2C_0_address_match(const struct i2c_s_async_descriptor *const descr)
+{
+    // The DFLL starts up while a write's bytes arrive, ready for the stop.
+    // Reads are answered by the DMAC alone, so don't need it.
+    if (!hri_sercomi2cs_get_STATUS_DIR_bit(SERCOM0)) {
+        clock_profile_boost();
+    }
+    iic_dma_address_match();
+    iic_transaction_active = true;
+}
+
+/// End of a transaction, the frame received in it is already in memory
+static void I2C_0_stop(const struct i2c_s_async_descriptor *const descr)
+{
+    iic_transaction_active = false;
+
+    if (iic_dma_stop()) {
+        iic_frame_received();
+    }
+}
+
+/// Setup asynchronous I2C slave
+void setup_iic(uint8_t address)
+{
+    i2c_s_async_register_callback(&I2C_0, I2C_S_ERROR, I2C_0_error);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_ADDRESS_MATCH, I2C_0_address_match);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_STOP, I2C_0_stop);
+    iic_dma_init();
+
+    i2c_s_async_set_addr(&I2C_0, address);
+    i2c_s_async_enable(&I2C_0);
+}
+
+#endif // IIC_DMA_ENABLED
+
+#if IIC_FAST_ENABLED || IIC_DMA_ENABLED
+
+/// Copies the receive overflow counts into bench_stats
+static void latch_iic_overflows(void)
+{
+    bench_stats.rx_nacks = iic_frame_counts.rx_nacks;
+    bench_stats.rx_frames_dropped = iic_frame_counts.frames_dropped;
+}
+
+static void get_iic_counts(struct telemetry_iic_counts *counts)
+{
+    counts->rx_bytes = iic_frame_counts.rx_bytes;
+    counts->rx_frames = iic_frame_counts.rx_frames;
+    counts->rx_nacks = iic_frame_counts.rx_nacks;
+    counts->rx_holds = 0; // Full frame buffers drop frames instead
+    counts->rx_frames_dropped = iic_frame_counts.frames_dropped;
+    counts->bus_errors = iic_frame_counts.bus_errors;
+}
+
+static const uint8_t *iic_get_tx_source(void)
+{
+    return iic_frames_get_tx_source();
+}
+
+static void iic_set_tx(const uint8_t *data, uint8_t length)
+{
+    iic_frames_set_tx(data, length);
+}
+
+#else // IIC_FAST_ENABLED || IIC_DMA_ENABLED
+
+/// What reads send, from the next read on
+static const uint8_t *volatile iic_tx_data = NULL;
+static volatile uint8_t iic_tx_length = 0;
+
+/// What the current or last read sends, and how far it's got
+///
+/// This is picked up on the first byte of a read, rather than from an address
+/// match interrupt, which would cost every write an interrupt too.  The stop
+/// condition rewinds it for the next read.
+static const uint8_t *volatile iic_tx_source = NULL;
+static uint8_t iic_tx_source_length = 0;
+static uint8_t iic_tx_position = 0;
+
+static volatile uint32_t iic_rx_bytes = 0;
+static volatile uint32_t iic_rx_frames = 0;
+
+/// Sends the next byte of a read, or 0xFF past the end
+///
+/// The HAL is only ever given one byte at a time, and asks for the next as it
+/// finishes with it, so a read cut short leaves nothing behind in the HAL for
+/// the next read to send.
+static void I2C_0_tx(const struct i2c_s_async_descriptor *const descr)
+{
+    static const uint8_t filler = 0xFF;
+    const uint8_t *byte = &filler;
+    struct io_descriptor *io;
+
+    if (!iic_tx_position) {
+        iic_tx_source = iic_tx_data;
+        iic_tx_source_length = iic_tx_length;
+    }
+
+    if (iic_tx_position < iic_tx_source_length) {
+        byte = &iic_tx_source[iic_tx_position];
+    }
+    if (iic_tx_position < UINT8_MAX) {
+        ++iic_tx_position;
+    }
+
+    i2c_s_async_get_io_descriptor(&I2C_0, &io);
+    io->write(io, byte, 1);
+}
+
+/// A byte that doesn't fit in the RX buffer is held until the main loop reads
+/// an earlier frame, or NACKed if the transaction has the whole buffer, so it
+/// never has more than SERCOM0_I2CS_BUFFER_SIZE bytes of frames in it.  Every
+/// frame is at least a byte, so there's at most one frame per byte, and with
+/// head == tail for empty the queue needs a slot more than that.
+#define IIC_FRAME_QUEUE_SIZE (SERCOM0_I2CS_BUFFER_SIZE + 1)
+
+/// Lengths of the frames waiting in the I2C RX buffer, oldest first
+static volatile uint8_t iic_frame_lengths[IIC_FRAME_QUEUE_SIZE];
+static volatile uint8_t iic_frame_head = 0;
+static volatile uint8_t iic_frame_tail = 0;
+
+/// Bytes received so far in the current frame
+static uint8_t iic_frame_length = 0;
+
+static void I2C_0_rx_complete(const struct i2c_s_async_descriptor *const descr)
+{
+    ++iic_rx_bytes;
+    if (iic_frame_length < UINT8_MAX) {
+        ++iic_frame_length;
+    }
+}
+
+/// End of a transaction, queue up whatever was received in it
+static void I2C_0_stop(const struct i2c_s_async_descriptor *const descr)
+{
+    iic_tx_position = 0;
+
+    if (!iic_frame_length) {
+        return; // Master read, or an empty write
+    }
+
+    iic_frame_lengths[iic_frame_head] = iic_frame_length;
+    iic_frame_head = (iic_frame_head + 1) % IIC_FRAME_QUEUE_SIZE;
+    iic_frame_length = 0;
+    ++iic_rx_frames;
+
+    iic_frame_received();
 }
 
-static void I2C_0_tx_complete(const struct i2c_s_async_descriptor *const descr)
+/// Takes the length of the oldest received frame off the queue
+static bool iic_next_frame_length(uint8_t *length)
 {
-    REG_SERCOM1_I2CS_CTRLB &= ~(1<<18); // Enable ACK
-    REG_SERCOM1_I2CS_CTRLB |= (3<<16); // Send ACK
+    if (iic_frame_tail == iic_frame_head) {
+        return false;
+    }
+
+    *length = iic_frame_lengths[iic_frame_tail];
+    iic_frame_tail = (iic_frame_tail + 1) % IIC_FRAME_QUEUE_SIZE;
+    return true;
 }
 
 /// Setup asynchronous I2C slave
 void setup_iic(uint8_t address)
 {
     i2c_s_async_register_callback(&I2C_0, I2C_S_ERROR, I2C_0_error);    
-    i2c_s_async_register_callback(&I2C_0, I2C_S_TX_COMPLETE, I2C_0_tx_complete);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_RX_COMPLETE, I2C_0_rx_complete);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_STOP, I2C_0_stop);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_TX_PENDING, I2C_0_tx);
+    i2c_s_async_register_callback(&I2C_0, I2C_S_TX_COMPLETE, I2C_0_tx);
+
+    // Every byte in the RX buffer is part of a queued frame, which the main
+    // loop is about to read, so holding the bus for room loses nothing
+    i2c_s_async_set_rx_overflow(&I2C_0, I2C_S_RX_OVERFLOW_STRETCH);
 
     i2c_s_async_set_addr(&I2C_0, address);
     i2c_s_async_enable(&I2C_0);    
 }
 
-void led_init(void)
+/// Copies the receive overflow counts into bench_stats
+static void latch_iic_overflows(void)
 {
-    gpio_set_pin_direction(SEGMENT_A_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_B_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_C_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_D_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_E_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_F_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_direction(SEGMENT_G_PIN, GPIO_DIRECTION_OUT);
-    gpio_set_pin_level(SEGMENT_A_PIN, 0);
-    gpio_set_pin_level(SEGMENT_B_PIN, 0);
-    gpio_set_pin_level(SEGMENT_C_PIN, 0);
-    gpio_set_pin_level(SEGMENT_D_PIN, 0);
-    gpio_set_pin_level(SEGMENT_E_PIN, 0);
-    gpio_set_pin_level(SEGMENT_F_PIN, 0);
-    gpio_set_pin_level(SEGMENT_G_PIN, 0);
+    bench_stats.rx_nacks = i2c_s_async_get_rx_nacks(&I2C_0);
+    bench_stats.rx_holds = i2c_s_async_get_rx_holds(&I2C_0);
+}
+
+static void get_iic_counts(struct telemetry_iic_counts *counts)
+{
+    counts->rx_bytes = iic_rx_bytes;
+    counts->rx_frames = iic_rx_frames;
+    counts->rx_nacks = i2c_s_async_get_rx_nacks(&I2C_0);
+    counts->rx_holds = i2c_s_async_get_rx_holds(&I2C_0);
+    counts->rx_frames_dropped = 0; // Writes are held or NACKed instead
+    counts->bus_errors = iic_frame_counts.bus_errors;
 }
 
-bool heartbeat_enabled = false;
+static const uint8_t *iic_get_tx_source(void)
+{
+    return iic_tx_source;
+}
 
-/// Don't start heartbeat right away - otherwise can't reprogram
+static void iic_set_tx(const uint8_t *data, uint8_t length)
+{
+    CRITICAL_SECTION_ENTER()
+    iic_tx_data = data;
+    iic_tx_length = length;
+    CRITICAL_SECTION_LEAVE()
+}
+
+#endif // IIC_FAST_ENABLED || IIC_DMA_ENABLED
+
+/// Set once a second, for the main loop to bring the telemetry up to date
+static volatile bool telemetry_due = false;
+
+/// Brings what a master reads up to date, see telemetry.h
+static void update_telemetry(void)
+{
+    struct telemetry_iic_counts counts;
+
+    get_iic_counts(&counts);
+
+    CRITICAL_SECTION_ENTER()
+    const struct telemetry *telemetry = telemetry_update(&counts, iic_get_tx_source());
+    iic_set_tx((const uint8_t *)telemetry, sizeof(*telemetry));
+    CRITICAL_SECTION_LEAVE()
+}
+
+/// CPU cycles spent awake so far this second, latched into bench_stats
+///
+/// Awake time is what's counted because SysTick stops along with the CPU
+/// clock in standby.  Cycles while boosted are a sixth as long, so this is
+/// more a count of work done than of time awake.
+static volatile uint32_t busy_cycles = 0;
+
+// Modes for sleep() from hal_sleep
+#define SLEEP_MODE_IDLE0 PM_SLEEP_IDLE_CPU_Val // Only the CPU clock stops
+#define SLEEP_MODE_IDLE2 PM_SLEEP_IDLE_APB_Val // CPU, AHB and APB clocks stop
+#define SLEEP_MODE_STANDBY 3 // All clocks stop, except for peripherals set to run in standby
+
+/// Sleep mode used while waiting for something to happen
+///
+/// SERCOM0, TC1 and TCC0 are set to run in standby, along with GCLK1 and
+/// OSC8M which clock them, so STANDBY still wakes on an I2C address match
+/// or timer tick and is by far the lowest current option.
+#define IDLE_SLEEP_MODE SLEEP_MODE_STANDBY
+
+/// Stay in a light sleep at first, so a debugger can still get in
+static uint8_t idle_sleep_mode = SLEEP_MODE_IDLE0;
+
+/// Don't start heartbeat or deep sleep right away - otherwise can't reprogram
 static void TIMER_0_task1_cb(const struct timer_task *const timer_task)
 {
-    heartbeat_enabled = true;
-    gpio_set_pin_direction(HEARTBEAT_PIN, GPIO_DIRECTION_OUT);
+    heartbeat_enable();
+    idle_sleep_mode = IDLE_SLEEP_MODE;
 }
 
-/// PWM the heartbeat LED
+/// Step the heartbeat LED brightness
 static void TIMER_0_task2_cb(const struct timer_task *const timer_task)
 {
-    static const int HEARTRATE = 3;
-    static const int HEARTBEAT_PWM_TICKS = 500;
-    static const int HEARTBEAT_MIN_BRIGHTNESS = 1;
-    static const int HEARTBEAT_MAX_BRIGHTNESS = 100;
-    static int heartbeat_counter = 0;
-    static int heartbeat_level = 0; // Brightness 0=off HEARTBEAT_PWM_TICKS=full
-    static bool beat_direction = false;
-
-    if (heartbeat_enabled) {
-        // low = light on
-        gpio_set_pin_level(HEARTBEAT_PIN, heartbeat_counter > heartbeat_level);
-
-        if (++heartbeat_counter >= HEARTBEAT_PWM_TICKS) {
-            heartbeat_counter = 0;
-
-            if (beat_direction) {
-                heartbeat_level += HEARTRATE;
-                if (heartbeat_level > HEARTBEAT_MAX_BRIGHTNESS) {
-                    beat_direction = false;
-                    heartbeat_level = HEARTBEAT_MAX_BRIGHTNESS;
-                }
-            } else {
-                heartbeat_level -= HEARTRATE;
-                if (heartbeat_level < HEARTBEAT_MIN_BRIGHTNESS) {
-                    beat_direction = true;
-                    heartbeat_level = HEARTBEAT_MIN_BRIGHTNESS;
-                }
-            }
+    heartbeat_step();
+}
+
+/// Latch the CPU load meter and overflow counts, and refresh the telemetry
+static void TIMER_0_task3_cb(const struct timer_task *const timer_task)
+{
+    bench_stats.busy_cycles_per_second = busy_cycles;
+    busy_cycles = 0;
+    latch_iic_overflows();
+    telemetry_due = true;
+}
+
+/// Sleeps until an interrupt, unless a received frame or the telemetry is
+/// already waiting.  The CPU drops back to OSC8M for the sleep, unless it's
+/// about to be needed for the frame coming in.
+static void wait_for_event(void)
+{
+    static uint32_t wake_time = 0;
+
+    CRITICAL_SECTION_ENTER()
+    // Interrupts are masked, so one arriving between the check and sleep()
+    // still wakes us; its handler runs once we leave the critical section
+    if (!iic_rx_pending && !telemetry_due) {
+        uint8_t mode = idle_sleep_mode;
+        bool stay_boosted = false;
+
+#if IIC_DMA_ENABLED
+        // The DMAC needs the AHB clock, so it can't move bytes in standby
+        if (iic_transaction_active) {
+            mode = SLEEP_MODE_IDLE0;
+            stay_boosted = true;
         }
+#endif
+
+        if (!stay_boosted) {
+            clock_profile_low();
+        }
+
+        busy_cycles += cycles_since(wake_time);
+        sleep(mode);
+        wake_time = cycle_counter_read();
     }
+    CRITICAL_SECTION_LEAVE()
 }
 
 int main(void)
 {
     atmel_start_init();
 
+#if !IIC_DMA_ENABLED && !IIC_FAST_ENABLED
     struct io_descriptor *i2c_slave;
     i2c_s_async_get_io_descriptor(&I2C_0, &i2c_slave);
-
-    setup_iic( get_address() );
-    led_init();
+#endif
+
+    uint8_t address = get_address();
+    clock_profile_init();
+    setup_iic(address);
+    protocol_set_slot(address - IIC_BASE_ADDRESS);
+    telemetry_set_address(address);
+    pwm_init();
+    display_init();
+    heartbeat_init();
+    bench_init();
+    update_telemetry();
 
     struct timer_task TIMER_0_task1;
-    TIMER_0_task1.interval = 400000;
+    TIMER_0_task1.interval = 8000;
     TIMER_0_task1.cb = TIMER_0_task1_cb;
     TIMER_0_task1.mode = TIMER_TASK_ONE_SHOT;
     timer_add_task(&TIMER_0, &TIMER_0_task1);
 
     struct timer_task TIMER_0_task2;
-    TIMER_0_task2.interval = 2;
+    TIMER_0_task2.interval = HEARTBEAT_STEP_MS;
     TIMER_0_task2.cb = TIMER_0_task2_cb;
     TIMER_0_task2.mode = TIMER_TASK_REPEAT;
     timer_add_task(&TIMER_0, &TIMER_0_task2);
 
-    timer_set_clock_cycles_per_tick(&TIMER_0, 20);
+    struct timer_task TIMER_0_task3;
+    TIMER_0_task3.interval = 1000;
+    TIMER_0_task3.cb = TIMER_0_task3_cb;
+    TIMER_0_task3.mode = TIMER_TASK_REPEAT;
+    timer_add_task(&TIMER_0, &TIMER_0_task3);
+
+    timer_set_clock_cycles_per_tick(&TIMER_0, TIMER_0_CYCLES_PER_TICK);
     timer_start(&TIMER_0);
 
-    uint8_t cmd_byte = 0;
     while (1) {
-        if (i2c_slave->read(i2c_slave, &cmd_byte, 1)) {
-            switch(cmd_byte) {
-                case ZERO:
-                case ONE:
-                case TWO:
-                case THREE:
-                case FOUR:
-                case FIVE:
-                case SIX:
-                case SEVEN:
-                case EIGHT:
-                case NINE:
-                case IIC_COMMAND_OFF: // show_digit() turns off segments for invalid digits
-                    show_digit(cmd_byte);
-                default:
-                    break;
+        wait_for_event();
+
+        if (telemetry_due) {
+            telemetry_due = false;
+            update_telemetry();
+        }
+
+        if (!iic_rx_pending) {
+            continue; // Woken by something else, probably a timer
+        }
+
+        uint32_t rx_timestamp = iic_rx_timestamp;
+        iic_rx_pending = false;
+
+        BENCH_BEGIN(BENCH_DISPATCH);
+#if IIC_FAST_ENABLED || IIC_DMA_ENABLED
+        const uint8_t *frame;
+        uint8_t length;
+        while (iic_frames_next(&frame, &length)) {
+            handle_frame(frame, length);
+            iic_frames_release();
+        }
+#else
+        uint8_t length;
+        while (iic_next_frame_length(&length)) {
+            uint8_t frame[SERCOM0_I2CS_BUFFER_SIZE];
+
+            // A frame can't outgrow the RX buffer, since its next byte would
+            // be NACKed, but don't trust that with the stack
+            if (length > sizeof(frame)) {
+                length = sizeof(frame);
             }
+
+            handle_frame(frame, i2c_slave->read(i2c_slave, frame, length));
         }
+#endif
+
+        BENCH_END(BENCH_DISPATCH);
+
+        bench_record(BENCH_STOP_TO_DISPLAY, cycles_since(rx_timestamp));
+
+        update_telemetry();
     }
 }
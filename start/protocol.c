@@ -0,0 +1,242 @@
+// IIC protocol spoken by the digit boards
+//
+#include "protocol.h"
+
+#include <string.h>
+
+#include "animation.h"
+#include "clock.h"
+#include "display.h"
+
+/// Last value written to each register
+static uint8_t registers[REG_COUNT] = {
+    [REG_BRIGHTNESS - REG_FIRST] = 0xFF,
+    [REG_DIGIT - REG_FIRST]      = IIC_COMMAND_OFF,
+    [REG_CLOCK_MODE - REG_FIRST] = CLOCK_OFF,
+    [REG_SCORE_TEAM - REG_FIRST] = SCORE_TEAM_NONE,
+};
+
+/// Offset of our byte in a broadcast frame, after the first byte
+static uint8_t board_slot = 0;
+
+void protocol_set_slot(uint8_t slot)
+{
+    board_slot = slot;
+}
+
+/// Ends a roll, before the master shows something else
+static void end_roll(void)
+{
+    if (animation_get_effect() == ANIMATION_ROLL) {
+        animation_stop();
+    }
+}
+
+static bool is_command(uint8_t byte)
+{
+    return byte <= NINE || byte == IIC_COMMAND_OFF;
+}
+
+static void handle_command(uint8_t cmd_byte)
+{
+    switch(cmd_byte) {
+        case ZERO:
+        case ONE:
+        case TWO:
+        case THREE:
+        case FOUR:
+        case FIVE:
+        case SIX:
+        case SEVEN:
+        case EIGHT:
+        case NINE:
+        case IIC_COMMAND_OFF: // show_digit() turns off segments for invalid digits
+            end_roll();
+            registers[REG_DIGIT - REG_FIRST] = cmd_byte;
+            show_digit(cmd_byte);
+        default:
+            break;
+    }
+}
+
+/// Starts an animation, with the REG_ANIM_x registers written so far
+static void animate(uint8_t animation)
+{
+    uint16_t step_ms = registers[REG_ANIM_STEP - REG_FIRST] * DISPLAY_BLINK_UNIT_MS;
+    uint8_t arg = registers[REG_ANIM_ARG - REG_FIRST];
+
+    // Registers hold where the animation ends up
+    switch(animation) {
+        case ANIMATE_STOP:
+            animation_stop();
+            break;
+
+        case ANIMATE_FADE_IN:
+            registers[REG_BRIGHTNESS - REG_FIRST] = arg;
+            animation_fade(step_ms, 0, arg);
+            break;
+
+        case ANIMATE_FADE_OUT:
+            animation_fade(step_ms, registers[REG_BRIGHTNESS - REG_FIRST], 0);
+            registers[REG_BRIGHTNESS - REG_FIRST] = 0;
+            break;
+
+        case ANIMATE_FLASH:
+            animation_flash(step_ms, arg);
+            break;
+
+        case ANIMATE_ROLL:
+            animation_roll(step_ms, registers[REG_DIGIT - REG_FIRST], arg);
+            registers[REG_DIGIT - REG_FIRST] = arg;
+            break;
+
+        case ANIMATE_CHASE:
+            animation_chase(step_ms, arg);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void write_register(uint8_t reg, uint8_t value)
+{
+    registers[reg - REG_FIRST] = value;
+
+    switch(reg) {
+        case REG_BRIGHTNESS:
+            if (animation_get_effect() == ANIMATION_FADE) {
+                animation_stop();
+            }
+            display_set_brightness(value);
+            break;
+
+        case REG_BLINK:
+            display_set_blink(value);
+            break;
+
+        case REG_DIGIT:
+            end_roll();
+            show_digit(value);
+            break;
+
+        case REG_SEGMENTS:
+            end_roll();
+            show_segments(value);
+            break;
+
+        case REG_GLYPH:
+            end_roll();
+            show_glyph(value);
+            break;
+
+        case REG_LATCH:
+            display_set_latched(value);
+            break;
+
+        case REG_ANIMATE:
+            animate(value);
+            break;
+
+        case REG_CLOCK_MODE:
+            if (value <= CLOCK_DOWN) {
+                clock_set_mode(value);
+            }
+            break;
+
+        case REG_CLOCK_PLACE:
+            clock_set_place(value);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/// Shows our digit of our team's score, from a BROADCAST_SCORES frame
+static void handle_scores(const uint8_t *frame, uint8_t length)
+{
+    uint16_t team = registers[REG_SCORE_TEAM - REG_FIRST];
+    uint8_t place = registers[REG_SCORE_PLACE - REG_FIRST];
+
+    if (team == SCORE_TEAM_NONE || 2 * team + 2 >= length) {
+        return;
+    }
+
+    // What's left of the score from our place up
+    uint16_t score = frame[2 * team + 1] | frame[2 * team + 2] << 8;
+    for (uint8_t i = 0; i < (place & ~SCORE_PLACE_SHOW_ZERO) && score; ++i) {
+        score /= 10;
+    }
+
+    if (!score && (place & ~SCORE_PLACE_SHOW_ZERO) && !(place & SCORE_PLACE_SHOW_ZERO)) {
+        write_register(REG_DIGIT, IIC_COMMAND_OFF);
+    } else {
+        write_register(REG_DIGIT, score % 10);
+    }
+}
+
+void handle_frame(const uint8_t *frame, uint8_t length)
+{
+    if (!length) {
+        return;
+    }
+
+    if (is_command(frame[0])) {
+        for (uint8_t i = 0; i < length; ++i) {
+            handle_command(frame[i]);
+        }
+        return;
+    }
+
+    if (frame[0] == COMMIT) {
+        display_commit();
+        return;
+    }
+
+    if (frame[0] == CLOCK_START) {
+        clock_start();
+        return;
+    }
+
+    if (frame[0] == CLOCK_STOP) {
+        clock_stop();
+        return;
+    }
+
+    if (frame[0] == CLOCK_SYNC) {
+        if (length >= 4) {
+            clock_sync(frame[1] | (uint32_t)frame[2] << 8 | (uint32_t)frame[3] << 16);
+        }
+        return;
+    }
+
+    if (frame[0] == CALIBRATE) {
+        if (length >= 3) {
+            clock_calibrate(frame[1] | frame[2] << 8);
+        }
+        return;
+    }
+
+    if (frame[0] == BROADCAST_SCORES) {
+        handle_scores(frame, length);
+        return;
+    }
+
+    if (frame[0] == BROADCAST_DIGITS || frame[0] == BROADCAST_GLYPHS) {
+        if (board_slot + 1 < length) {
+            write_register(frame[0] == BROADCAST_DIGITS ? REG_DIGIT : REG_GLYPH, frame[board_slot + 1]);
+        }
+        return;
+    }
+
+    uint8_t reg = frame[0];
+    for (uint8_t i = 1; i < length && reg >= REG_FIRST && reg < REG_END; ++i, ++reg) {
+        write_register(reg, frame[i]);
+    }
+}
+
+void protocol_get_registers(uint8_t *values)
+{
+    memcpy(values, registers, sizeof(registers));
+}
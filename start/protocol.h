@@ -0,0 +1,155 @@
+// IIC protocol spoken by the digit boards
+//
+// The original protocol is one byte per transaction: 0-9 shows that digit and
+// IIC_COMMAND_OFF blanks the display.  Any transaction starting with one of
+// those bytes is still handled that way, a byte at a time.
+//
+// Otherwise, the first byte of a write is a register address, and each byte
+// after it is written to the next register up.  So the whole state of a digit
+// can be set in one transaction, eg:
+//
+//   START, address+W, REG_BRIGHTNESS, 0xFF, 0, 7, STOP
+//
+// sets full brightness, no blinking, and shows a 7.  Writes past the last
+// register are ignored.
+//
+// Every board also answers the general call address (0x00), so the whole
+// scoreboard can be updated in one transaction with a broadcast frame:
+//
+//   START, 0x00+W, BROADCAST_DIGITS, digit 0, digit 1, ... digit 7, STOP
+//
+// Each board shows the digit in the slot matching its ADDR jumper offset, and
+// leaves the display alone if the frame is too short to reach its slot.
+//
+// Letters and symbols can be shown as ASCII characters instead, with
+// REG_GLYPH or a BROADCAST_GLYPHS frame, or any pattern at all with
+// REG_SEGMENTS.
+//
+// Scores can be broadcast as numbers, and each board picks out its own digit.
+// Set each board's REG_SCORE_TEAM and REG_SCORE_PLACE once, and then every
+// score change is one frame, eg:
+//
+//   START, 0x00+W, BROADCAST_SCORES, 0x2A, 0x00, 0x07, 0x01, STOP
+//
+// for scores of 42 and 263.  Each score is 16 bits, least significant byte
+// first.  Zeros in front of a score are blanked, but the units always show.
+//
+// For changes that have to appear on several digits at once, set REG_LATCH on
+// each board (a register write to the general call address does them all),
+// write the new values, and then broadcast a COMMIT frame.  Every board
+// receives the COMMIT together and switches to its new value.
+//
+// Animations run on the board once started, so they take one transaction
+// however many steps they have.  REG_ANIMATE starts one, using the two
+// registers before it, so they can all be written together, eg:
+//
+//   START, address+W, REG_ANIM_STEP, 5, 7, ANIMATE_ROLL, STOP
+//
+// rolls the digit up to 7, one digit every 50ms.  A write to REG_BRIGHTNESS
+// ends a fade, and a write of a digit or segments ends a roll, so the master
+// can always take over again.
+//
+// Boards can also count a shot clock or game clock between them, see clock.h.
+// Each board's REG_CLOCK_PLACE picks its digit of the time, and then every
+// board can be set up and run together by broadcasts, eg:
+//
+//   START, 0x00+W, REG_CLOCK_MODE, CLOCK_DOWN, STOP
+//   START, 0x00+W, CLOCK_SYNC, 0xF0, 0x00, 0x00, STOP
+//   START, 0x00+W, CLOCK_START, STOP
+//
+// counts down from 24.0 seconds.  CLOCK_SYNC takes the time in tenths of a
+// second as 3 bytes, least significant first, and can be sent again while the
+// clock runs to bring the boards back into step.
+//
+// To keep the boards' clocks in step between syncs, the master should
+// broadcast a CALIBRATE frame every second or so, with the time since the
+// last one by its own clock in milliseconds, eg:
+//
+//   START, 0x00+W, CALIBRATE, 0xE8, 0x03, STOP
+//
+// for 1000ms.  The boards measure the same interval on their own clocks, and
+// correct for the difference - see calibration.h.
+//
+// Reads from a board's own address get its telemetry, see telemetry.h.
+//
+#ifndef PROTOCOL_H_INCLUDED
+#define PROTOCOL_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// These need to be representable with 8-bits
+enum IIC_command_enum {
+    ZERO,
+    ONE,
+    TWO,
+    THREE,
+    FOUR,
+    FIVE,
+    SIX,
+    SEVEN,
+    EIGHT,
+    NINE,
+
+    IIC_COMMAND_OFF = 0xFF
+};
+
+/// Register addresses, clear of the single byte commands
+enum IIC_register_enum {
+    REG_BRIGHTNESS = 0x10, // 0 is off, see display_set_brightness()
+    REG_BLINK,             // Blink half period in DISPLAY_BLINK_UNIT_MS, 0 for steady
+    REG_DIGIT,             // Digit to show, 0-9, anything else blanks
+    REG_SEGMENTS,          // Raw pattern of SEGMENT_x_BITs to show
+    REG_LATCH,             // Non-zero holds REG_DIGIT/REG_SEGMENTS until a COMMIT frame
+    REG_ANIM_STEP,         // Animation step period in DISPLAY_BLINK_UNIT_MS, 0 skips to the end
+    REG_ANIM_ARG,          // Fade brightness, roll digit, or count of flashes/laps (0 for ever)
+    REG_ANIMATE,           // Writing an IIC_animation_enum starts that animation
+    REG_CLOCK_MODE,        // clock_mode, CLOCK_OFF leaves the digit to the master
+    REG_CLOCK_PLACE,       // clock_place of the digit shown, maybe | CLOCK_PLACE_BLANK_ZERO
+    REG_GLYPH,             // ASCII character to show, see show_glyph()
+    REG_SCORE_TEAM,        // Which score of a BROADCAST_SCORES frame to show, or SCORE_TEAM_NONE
+    REG_SCORE_PLACE,       // Power of ten of the score digit shown, maybe | SCORE_PLACE_SHOW_ZERO
+
+    REG_END
+};
+
+#define REG_FIRST REG_BRIGHTNESS
+#define REG_COUNT (REG_END - REG_FIRST)
+
+/// Values for REG_ANIMATE, see animation.h
+enum IIC_animation_enum {
+    ANIMATE_STOP,     // Skips whatever's running to its end
+    ANIMATE_FADE_IN,  // Brightness from 0 up to REG_ANIM_ARG
+    ANIMATE_FADE_OUT, // Brightness from REG_BRIGHTNESS down to 0
+    ANIMATE_FLASH,    // Blanks REG_ANIM_ARG times
+    ANIMATE_ROLL,     // Counts up from REG_DIGIT to REG_ANIM_ARG
+    ANIMATE_CHASE,    // Runs a segment round the outside REG_ANIM_ARG times
+};
+
+/// Frames for the general call address, outside of the register map
+enum IIC_broadcast_enum {
+    BROADCAST_DIGITS = 0x20, // One byte per board, as for REG_DIGIT
+    COMMIT,                  // Shows whatever was written while REG_LATCH was set
+    CLOCK_START,             // Starts the clock counting
+    CLOCK_STOP,              // Stops the clock where it is
+    CLOCK_SYNC,              // Sets the clock, to the 24 bit number of tenths following
+    CALIBRATE,               // Sent at a steady interval, given in the 16 bit ms following
+    BROADCAST_GLYPHS,        // One byte per board, as for REG_GLYPH
+    BROADCAST_SCORES,        // Two bytes per team score, see REG_SCORE_TEAM
+};
+
+/// REG_SCORE_TEAM of a board that isn't part of a score
+#define SCORE_TEAM_NONE 0xFF
+
+/// Or'd with REG_SCORE_PLACE, shows a leading 0 rather than blanking it
+#define SCORE_PLACE_SHOW_ZERO 0x80
+
+/// Sets which slot of a broadcast frame this board uses, from 0
+void protocol_set_slot(uint8_t slot);
+
+/// Handles one complete write transaction from the master
+void handle_frame(const uint8_t *frame, uint8_t length);
+
+/// Copies the REG_COUNT register values, from REG_FIRST up
+void protocol_get_registers(uint8_t *values);
+
+#endif // PROTOCOL_H_INCLUDED
@@ -0,0 +1,44 @@
+// TCC0 PWM, shared by the heartbeat LED and the segments
+//
+#include "pwm.h"
+
+#include <hpl_gclk_base.h>
+#include <hpl_pm_base.h>
+
+#include "ramfunc.h"
+
+void pwm_init(void)
+{
+    _pm_enable_bus_clock(PM_BUS_APBC, TCC0);
+
+    // GCLK1 stays on OSC8M while the CPU clock changes, see clock_profile.h
+    _gclk_enable_channel(TCC0_GCLK_ID, GCLK_CLKCTRL_GEN_GCLK1_Val);
+
+    hri_tcc_set_CTRLA_SWRST_bit(TCC0);
+    hri_tcc_wait_for_sync(TCC0, TCC_SYNCBUSY_SWRST);
+
+    // Keeps running while the CPU is in standby
+    hri_tcc_write_CTRLA_reg(TCC0, TCC_CTRLA_PRESCALER_DIV16 | TCC_CTRLA_RUNSTDBY);
+    hri_tcc_write_WAVE_reg(TCC0, TCC_WAVE_WAVEGEN_NPWM);
+    hri_tcc_wait_for_sync(TCC0, TCC_SYNCBUSY_WAVE);
+
+    hri_tcc_write_PER_reg(TCC0, PWM_PERIOD_TICKS - 1);
+    hri_tcc_wait_for_sync(TCC0, TCC_SYNCBUSY_PER);
+
+    // CC registers reset to 0, so every output starts low
+
+    hri_tcc_set_CTRLA_ENABLE_bit(TCC0);
+    hri_tcc_wait_for_sync(TCC0, TCC_SYNCBUSY_ENABLE);
+}
+
+void pwm_set_duty(uint8_t cc, uint16_t high_ticks)
+{
+    hri_tcc_write_CCB_reg(TCC0, cc, high_ticks);
+}
+
+HOT_RAMFUNC void pwm_hold_low(uint8_t wo_mask)
+{
+    // PGE forces the output to its PGV bit, which is left at 0
+    hri_tcc_wait_for_sync(TCC0, TCC_SYNCBUSY_PATT);
+    hri_tcc_write_PATT_reg(TCC0, TCC_PATT_PGE(wo_mask));
+}
@@ -0,0 +1,29 @@
+// TCC0 PWM, shared by the heartbeat LED and the segments
+//
+// TCC0 has four compare channels feeding eight waveform outputs, WO[n] follows
+// CC[n % 4].  The heartbeat has CC2, the segments share the others, and all of
+// them run off the one period.
+//
+#ifndef PWM_H_INCLUDED
+#define PWM_H_INCLUDED
+
+#include <atmel_start.h>
+
+/// TCC0 counts at 8MHz / 16 = 500kHz, so 500 counts gives a 1kHz PWM
+#define PWM_PERIOD_TICKS 500
+
+/// Sets up and starts TCC0, with every output low
+void pwm_init(void);
+
+/// Sets how many ticks of each period channel cc is high for
+///
+/// Buffered, so it takes effect at the end of the current period.  Anything
+/// over PWM_PERIOD_TICKS - 1 leaves the output high.
+void pwm_set_duty(uint8_t cc, uint16_t high_ticks);
+
+/// Holds the outputs in wo_mask low, and lets the rest follow their channel
+///
+/// Not buffered, so the outputs all change together straight away.
+void pwm_hold_low(uint8_t wo_mask);
+
+#endif // PWM_H_INCLUDED
@@ -0,0 +1,28 @@
+// Running the interrupt handlers on the I2C to display path from SRAM
+//
+// Once flash needs wait states (CONF_NVM_WAIT_STATE, which the SAMD10 needs
+// above 24MHz), every instruction fetched from it stalls the CPU, and an
+// interrupt handler is mostly instruction fetches.  SRAM never waits.
+//
+// Functions marked HOT_RAMFUNC, or CONF_ISR_ATTR in the drivers, get ASF's
+// RAMFUNC, which puts them in .ramfunc.  The linker scripts put that in
+// .relocate along with .data, and Reset_Handler copies it into SRAM.
+// Everything is built with -mlong-calls, so calls between flash and SRAM need
+// nothing more.
+//
+// SRAM is only 4kB, so this is kept to the few functions that run on every
+// interrupt or every displayed digit.  The .ramfunc lines of the map file
+// show what it costs.  It's on whenever flash always has wait states, or
+// build with -DRAMFUNC_ENABLED=0 or 1, or set it in config/isr_hooks_config.h,
+// to choose.  The wait state only added while the CPU is boosted (see
+// clock_profile.h) doesn't turn it on, as the handlers mostly run at 8MHz
+// without it.
+//
+#ifndef RAMFUNC_H_INCLUDED
+#define RAMFUNC_H_INCLUDED
+
+#include <isr_hooks_config.h>
+
+#define HOT_RAMFUNC CONF_ISR_ATTR
+
+#endif // RAMFUNC_H_INCLUDED
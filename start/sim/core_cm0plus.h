@@ -0,0 +1,76 @@
+// Stand-in for the CMSIS Cortex-M0+ core header, for the host simulator
+//
+// Only covers what the firmware and ASF actually use.  Interrupt masking,
+// the NVIC and WFI are implemented in sim_core.c, which is where simulated
+// time moves forward.
+//
+#ifndef SIM_CORE_CM0PLUS_H_INCLUDED
+#define SIM_CORE_CM0PLUS_H_INCLUDED
+
+#include <stdint.h>
+
+#define __I   volatile const
+#define __O   volatile
+#define __IO  volatile
+#define __IM  volatile const
+#define __OM  volatile
+#define __IOM volatile
+
+#define __STATIC_INLINE static inline
+#define __INLINE inline
+#define __ASM __asm__
+
+typedef struct {
+    __IO uint32_t CTRL;
+    __IO uint32_t LOAD;
+    __IO uint32_t VAL;
+    __I  uint32_t CALIB;
+} SysTick_Type;
+
+#define SysTick_CTRL_ENABLE_Msk     (1UL << 0)
+#define SysTick_CTRL_TICKINT_Msk    (1UL << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (1UL << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (1UL << 16)
+#define SysTick_LOAD_RELOAD_Msk     0xFFFFFFUL
+#define SysTick_VAL_CURRENT_Msk     0xFFFFFFUL
+
+typedef struct {
+    __I  uint32_t CPUID;
+    __IO uint32_t ICSR;
+    __IO uint32_t VTOR;
+    __IO uint32_t AIRCR;
+    __IO uint32_t SCR;
+    __IO uint32_t CCR;
+} SCB_Type;
+
+#define SCB_ICSR_VECTACTIVE_Msk     0x1FFUL
+#define SCB_SCR_SLEEPDEEP_Msk       (1UL << 2)
+
+extern SysTick_Type sim_systick;
+extern SCB_Type     sim_scb;
+
+#define SysTick (&sim_systick)
+#define SCB     (&sim_scb)
+
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPendingIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority);
+void NVIC_SystemReset(void);
+
+uint32_t __get_IPSR(void);
+uint32_t __get_PRIMASK(void);
+void     __set_PRIMASK(uint32_t primask);
+void     __disable_irq(void);
+void     __enable_irq(void);
+void     __WFI(void);
+
+// Nothing is reordered on the simulated bus, but the compiler still mustn't
+// move memory accesses across these
+#define __DMB() __asm__ volatile("" ::: "memory")
+#define __DSB() __asm__ volatile("" ::: "memory")
+#define __ISB() __asm__ volatile("" ::: "memory")
+#define __NOP() __asm__ volatile("" ::: "memory")
+
+#endif // SIM_CORE_CM0PLUS_H_INCLUDED
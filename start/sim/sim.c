@@ -0,0 +1,936 @@
+// Host simulator for the digit firmware
+//
+// Runs the real firmware and ASF on the simulated bus from sim_bus.c, with
+// simple models of the peripherals the firmware uses:
+//
+//   - SERCOM0 as an I2C slave, fed transactions from a script
+//   - TC1/TC2, counting and raising overflow interrupts
+//   - TCC0, for its PWM outputs and interrupts
+//   - DMAC, moving a beat whenever a SERCOM0 trigger asks for one
+//   - PORT, with the ADDR jumpers between segment pins
+//
+// and writes the segment (and heartbeat) outputs out as a VCD waveform.  The
+// script's times are by the master's clock, and the board's OSC8M can be set
+// to run fast or slow against it, to try out the calibration.  Run
+// it with -h for the options, and see example.i2c for the script format.
+//
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+#include "../display.h"
+
+int firmware_main(void);
+
+#define CYCLES_PER_MS (SIM_CPU_HZ / 1000)
+
+/// How long a slave may hold SCL low before the simulated master gives up
+#define I2C_STRETCH_TIMEOUT_MS 25
+
+#define I2C_MAX_LENGTH 64
+
+uint64_t sim_now = 0;
+
+static uint64_t end_time = 0;
+
+/// Bit n is set if ADDRn+1 is jumped
+static uint8_t jumpers = 0;
+
+static unsigned long bus_hz = 100000;
+static uint32_t i2c_bit_cycles;
+
+/// Board CPU cycles in each of the master's, for an OSC8M off frequency
+static double osc_ratio = 1.0;
+
+static FILE *vcd = NULL;
+
+/// Print interrupt counts at the end
+static bool report = false;
+
+static const uint16_t prescales[] = {1, 2, 4, 8, 16, 64, 256, 1024};
+
+/// Board CPU cycles at a time by the master's clock, as in the script
+static uint64_t master_ms_to_cycles(double ms)
+{
+    return (uint64_t)(ms * CYCLES_PER_MS * osc_ratio);
+}
+
+/// Time by the master's clock, in microseconds, after some board CPU cycles
+static uint64_t cycles_to_master_us(uint64_t cycles)
+{
+    return (uint64_t)(cycles * (1000000.0 / SIM_CPU_HZ) / osc_ratio);
+}
+
+// PORT ----------------------------------------------------------------------
+
+/// Pins joined by the ADDR jumpers, see get_address()
+static const struct {
+    uint8_t drive;
+    uint8_t sense;
+} jumper_pins[] = {
+    {GPIO_PIN(SEGMENT_B_PIN), GPIO_PIN(SEGMENT_C_PIN)},
+    {GPIO_PIN(SEGMENT_D_PIN), GPIO_PIN(SEGMENT_E_PIN)},
+    {GPIO_PIN(SEGMENT_A_PIN), GPIO_PIN(SEGMENT_G_PIN)},
+};
+
+uint32_t sim_port_inputs(void)
+{
+    PortGroup *group = &PORT->Group[0];
+    uint32_t dir = group->DIR.reg;
+    uint32_t out = group->OUT.reg;
+    uint32_t in = out & dir;
+
+    // Pulls follow OUT on inputs
+    for (uint8_t pin = 0; pin < 32; ++pin) {
+        if (!(dir & (1UL << pin)) && group->PINCFG[pin].bit.PULLEN) {
+            in |= out & (1UL << pin);
+        }
+    }
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(jumper_pins); ++i) {
+        uint32_t drive = 1UL << jumper_pins[i].drive;
+        uint32_t sense = 1UL << jumper_pins[i].sense;
+
+        if ((jumpers & (1 << i)) && (dir & drive) && (out & drive) && !(dir & sense)) {
+            in |= sense;
+        }
+    }
+
+    return in;
+}
+
+// TC ------------------------------------------------------------------------
+
+static Tc *const tcs[] = {TC1, TC2};
+
+static struct {
+    bool     running;
+    uint64_t last; // Start of the current count, in CPU cycles
+} tc_states[ARRAY_SIZE(tcs)];
+
+static uint32_t tc_prescale(Tc *tc)
+{
+    return prescales[tc->COUNT16.CTRLA.bit.PRESCALER];
+}
+
+/// CPU cycles between overflows
+static uint64_t tc_period(Tc *tc)
+{
+    uint8_t wavegen = tc->COUNT16.CTRLA.bit.WAVEGEN;
+    bool cc0_top = wavegen == TC_CTRLA_WAVEGEN_MFRQ_Val || wavegen == TC_CTRLA_WAVEGEN_MPWM_Val;
+    uint64_t top;
+
+    switch(tc->COUNT16.CTRLA.bit.MODE) {
+        case TC_CTRLA_MODE_COUNT32_Val:
+            top = cc0_top ? tc->COUNT32.CC[0].reg : UINT32_MAX;
+            break;
+        case TC_CTRLA_MODE_COUNT8_Val:
+            top = cc0_top ? tc->COUNT8.CC[0].reg : tc->COUNT8.PER.reg;
+            break;
+        default:
+            top = cc0_top ? tc->COUNT16.CC[0].reg : UINT16_MAX;
+            break;
+    }
+
+    return (top + 1) * tc_prescale(tc);
+}
+
+static uint64_t tc_next(void)
+{
+    uint64_t next = UINT64_MAX;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(tcs); ++i) {
+        if (tc_states[i].running && tcs[i]->COUNT16.INTENSET.reg) {
+            next = min(next, tc_states[i].last + tc_period(tcs[i]));
+        }
+    }
+
+    return next;
+}
+
+static void tc_update(void)
+{
+    for (uint8_t i = 0; i < ARRAY_SIZE(tcs); ++i) {
+        Tc *tc = tcs[i];
+
+        if (!tc->COUNT16.CTRLA.bit.ENABLE) {
+            tc_states[i].running = false;
+            continue;
+        }
+
+        if (!tc_states[i].running) {
+            tc_states[i].running = true;
+            tc_states[i].last = sim_now;
+        }
+
+        uint64_t period = tc_period(tc);
+        if (sim_now >= tc_states[i].last + period) {
+            tc_states[i].last += (sim_now - tc_states[i].last) / period * period;
+            tc->COUNT16.INTFLAG.reg |= TC_INTFLAG_OVF;
+        }
+
+        uint32_t count = (sim_now - tc_states[i].last) / tc_prescale(tc);
+        switch(tc->COUNT16.CTRLA.bit.MODE) {
+            case TC_CTRLA_MODE_COUNT32_Val: tc->COUNT32.COUNT.reg = count; break;
+            case TC_CTRLA_MODE_COUNT8_Val: tc->COUNT8.COUNT.reg = count; break;
+            default: tc->COUNT16.COUNT.reg = count; break;
+        }
+    }
+}
+
+// TCC -----------------------------------------------------------------------
+
+/// TCC0 waveform outputs, from the PORT function that gives them
+static const struct {
+    uint32_t pinmux;
+    uint8_t  wo;
+} tcc_outputs[] = {
+    {PINMUX_PA04F_TCC0_WO0, 0}, {PINMUX_PA14F_TCC0_WO0, 0},
+    {PINMUX_PA05F_TCC0_WO1, 1}, {PINMUX_PA15F_TCC0_WO1, 1},
+    {PINMUX_PA30F_TCC0_WO2, 2}, {PINMUX_PA08E_TCC0_WO2, 2},
+    {PINMUX_PA24E_TCC0_WO2, 2}, {PINMUX_PA31F_TCC0_WO3, 3},
+    {PINMUX_PA09E_TCC0_WO3, 3}, {PINMUX_PA25E_TCC0_WO3, 3},
+    {PINMUX_PA24F_TCC0_WO4, 4}, {PINMUX_PA08F_TCC0_WO4, 4},
+    {PINMUX_PA25F_TCC0_WO5, 5}, {PINMUX_PA09F_TCC0_WO5, 5},
+};
+
+static struct {
+    bool     running;
+    uint64_t start; // When TCC0 was enabled
+    uint64_t done;  // Everything up to here has happened
+} tcc_state;
+
+static uint32_t tcc_prescale(void)
+{
+    return prescales[TCC0->CTRLA.bit.PRESCALER];
+}
+
+static uint64_t tcc_period(void)
+{
+    return ((uint64_t)(TCC0->PER.reg & 0xFFFFFF) + 1) * tcc_prescale();
+}
+
+static uint64_t tcc_next(void)
+{
+    uint32_t inten = TCC0->INTENSET.reg;
+
+    if (!tcc_state.running || !(inten & (TCC_INTENSET_OVF | TCC_INTENSET_MC_Msk))) {
+        return UINT64_MAX;
+    }
+
+    uint64_t period = tcc_period();
+    uint64_t start = tcc_state.start + (tcc_state.done - tcc_state.start) / period * period;
+    uint64_t next = start + period;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(TCC0->CC); ++i) {
+        uint32_t cc = TCC0->CC[i].reg & 0xFFFFFF;
+
+        if ((inten & (TCC_INTENSET_MC0 << i)) && cc * tcc_prescale() < period) {
+            uint64_t match = start + cc * tcc_prescale();
+            next = min(next, match > tcc_state.done ? match : match + period);
+        }
+    }
+
+    return next;
+}
+
+/// What happens at the end of every period
+static void tcc_buffer_update(void)
+{
+    Tcc *tcc = TCC0;
+
+    if (tcc->CTRLBSET.bit.LUPD) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(tcc->CC); ++i) {
+        if (tcc->STATUS.reg & (TCC_STATUS_CCBV0 << i)) {
+            tcc->CC[i].reg = tcc->CCB[i].reg;
+        }
+    }
+    if (tcc->STATUS.reg & TCC_STATUS_PERBV) {
+        tcc->PER.reg = tcc->PERB.reg;
+    }
+    if (tcc->STATUS.reg & TCC_STATUS_PATTBV) {
+        tcc->PATT.reg = tcc->PATTB.reg;
+    }
+    tcc->STATUS.reg &= ~(TCC_STATUS_CCBV_Msk | TCC_STATUS_PERBV | TCC_STATUS_PATTBV);
+}
+
+static void tcc_update(void)
+{
+    Tcc *tcc = TCC0;
+
+    if (!tcc->CTRLA.bit.ENABLE) {
+        tcc_state.running = false;
+        return;
+    }
+
+    if (!tcc_state.running) {
+        tcc_state.running = true;
+        tcc_state.start = tcc_state.done = sim_now;
+        return;
+    }
+
+    uint64_t period = tcc_period();
+    uint64_t start = tcc_state.start + (sim_now - tcc_state.start) / period * period;
+    uint32_t flags = 0;
+
+    // Compare matches in this period, and the end of the last one
+    for (uint8_t i = 0; i < ARRAY_SIZE(tcc->CC); ++i) {
+        uint64_t match = (uint64_t)(tcc->CC[i].reg & 0xFFFFFF) * tcc_prescale();
+
+        if (match < period && ((start + match > tcc_state.done && start + match <= sim_now) ||
+                               (start > tcc_state.done && start - period + match > tcc_state.done))) {
+            flags |= TCC_INTFLAG_MC0 << i;
+        }
+    }
+
+    if (start > tcc_state.done) {
+        flags |= TCC_INTFLAG_OVF;
+        tcc_buffer_update();
+    }
+
+    tcc_state.done = sim_now;
+    tcc->INTFLAG.reg |= flags;
+}
+
+/// How much of the time a TCC0 output is high, 0 to 1
+static double tcc_output_level(uint8_t wo)
+{
+    Tcc *tcc = TCC0;
+    double level;
+
+    if (!tcc->CTRLA.bit.ENABLE) {
+        level = 0;
+    } else if (tcc->PATT.reg & TCC_PATT_PGE(1 << wo)) {
+        level = (tcc->PATT.reg & TCC_PATT_PGV(1 << wo)) ? 1 : 0;
+    } else {
+        uint32_t cc = tcc->CC[wo % 4].reg & 0xFFFFFF;
+        uint32_t per = tcc->PER.reg & 0xFFFFFF;
+
+        // Normal PWM: high from the start of the period up to the match
+        level = cc > per ? 1 : (double)cc / (per + 1);
+    }
+
+    if (tcc->DRVCTRL.reg & (TCC_DRVCTRL_INVEN0 << wo)) {
+        level = 1 - level;
+    }
+
+    return level;
+}
+
+// DMAC ----------------------------------------------------------------------
+
+/// True if a channel's trigger is asking for a beat
+static bool dmac_triggered(uint8_t trigsrc)
+{
+    SercomI2cs *i2cs = &SERCOM0->I2CS;
+    bool drdy = i2cs->INTFLAG.reg & SERCOM_I2CS_INTFLAG_DRDY;
+
+    switch(trigsrc) {
+        case SERCOM0_DMAC_ID_RX: return drdy && !i2cs->STATUS.bit.DIR;
+        case SERCOM0_DMAC_ID_TX: return drdy && i2cs->STATUS.bit.DIR;
+        default: return false;
+    }
+}
+
+/// The DMAC stops along with the AHB clock, in IDLE1 and deeper
+static bool dmac_clocked(void)
+{
+    return !(sim_scb.SCR & SCB_SCR_SLEEPDEEP_Msk) && PM->SLEEP.bit.IDLE == PM_SLEEP_IDLE_CPU_Val;
+}
+
+/// Moves one beat on a channel, every trigger being a beat trigger
+static void dmac_beat(uint8_t i)
+{
+    struct sim_dmac_channel *channel = &sim_dmac_channels[i];
+    DmacDescriptor *descriptor = &channel->current;
+
+    if (!channel->fetched) {
+        *descriptor = ((DmacDescriptor *)(uintptr_t)DMAC->BASEADDR.reg)[i];
+        channel->fetched = true;
+    }
+    if (!descriptor->BTCTRL.bit.VALID) {
+        channel->intflag |= DMAC_CHINTFLAG_TERR;
+        sim_dmac_disable(i);
+        return;
+    }
+
+    // Incrementing addresses point at the end of the block
+    uint16_t left = descriptor->BTCNT.reg;
+    uint8_t size = 1 << descriptor->BTCTRL.bit.BEATSIZE;
+    uintptr_t src = descriptor->SRCADDR.reg - (descriptor->BTCTRL.bit.SRCINC ? left * size : 0);
+    uintptr_t dst = descriptor->DSTADDR.reg - (descriptor->BTCTRL.bit.DSTINC ? left * size : 0);
+
+    sim_bus_transfer(dst, src, size);
+
+    if (--descriptor->BTCNT.reg) {
+        return;
+    }
+
+    bool last = !descriptor->DESCADDR.reg;
+    if (last || (descriptor->BTCTRL.bit.BLOCKACT & DMAC_BTCTRL_BLOCKACT_INT_Val)) {
+        channel->intflag |= DMAC_CHINTFLAG_TCMPL;
+    }
+    if (last) {
+        sim_dmac_disable(i);
+    } else {
+        *descriptor = *(DmacDescriptor *)(uintptr_t)descriptor->DESCADDR.reg;
+    }
+}
+
+static void dmac_update(void)
+{
+    Dmac *dmac = DMAC;
+    bool moved = true;
+
+    if (!(dmac->CTRL.reg & DMAC_CTRL_DMAENABLE) || !dmac_clocked()) {
+        return;
+    }
+
+    // Keep going until every trigger has been dealt with
+    while (moved) {
+        moved = false;
+        for (uint8_t i = 0; i < DMAC_CH_NUM; ++i) {
+            struct sim_dmac_channel *channel = &sim_dmac_channels[i];
+            DMAC_CHCTRLB_Type ctrlb = {.reg = channel->ctrlb};
+
+            if ((channel->ctrla & DMAC_CHCTRLA_ENABLE) &&
+                (dmac->CTRL.reg & (DMAC_CTRL_LVLEN0 << ctrlb.bit.LVL)) &&
+                dmac_triggered(ctrlb.bit.TRIGSRC)) {
+                dmac_beat(i);
+                moved = true;
+            }
+        }
+    }
+
+    sim_dmac_show_channel();
+}
+
+// SERCOM0 I2C slave ---------------------------------------------------------
+
+struct transaction {
+    uint64_t start;
+    uint8_t  address;
+    bool     read;
+    uint8_t  length;
+    uint8_t  data[I2C_MAX_LENGTH];
+};
+
+static struct transaction *script = NULL;
+static size_t script_length = 0;
+
+enum i2c_phase {
+    I2C_ADDRESS,
+    I2C_DATA,
+    I2C_STOP,
+};
+
+static struct {
+    size_t              next;     // Next transaction to start from the script
+    struct transaction *current;  // Or NULL while the bus is idle
+    enum i2c_phase      phase;
+    uint8_t             index;    // Of the next data byte
+    uint64_t            at;       // When the current phase happens
+    uint64_t            held;     // When the slave started stretching, or 0
+    uint64_t            began;    // When the current transaction took the bus
+    char                result[32]; // What to log the transaction with, if anything
+} i2c;
+
+/// Transactions completed, and the bus time they took, stretching included
+static uint32_t i2c_transactions = 0;
+static uint64_t i2c_busy_cycles = 0;
+
+bool sim_i2c_nacked = false;
+
+static uint64_t i2c_next(void)
+{
+    if (i2c.current) {
+        return i2c.at;
+    }
+    if (i2c.next < script_length) {
+        return max(script[i2c.next].start, sim_now);
+    }
+    return UINT64_MAX;
+}
+
+static void i2c_flag(uint8_t flag)
+{
+    SERCOM0->I2CS.INTFLAG.reg |= flag;
+}
+
+static bool i2c_address_match(uint8_t address)
+{
+    SercomI2cs *i2cs = &SERCOM0->I2CS;
+    uint32_t mask = i2cs->ADDR.bit.ADDRMASK;
+
+    if (!i2cs->CTRLA.bit.ENABLE) {
+        return false;
+    }
+    if (address == 0) {
+        return i2cs->ADDR.bit.GENCEN;
+    }
+    return ((address ^ i2cs->ADDR.bit.ADDR) & ~mask & 0x7F) == 0;
+}
+
+static void i2c_log(const struct transaction *t, const char *result)
+{
+    printf("%10.3f ms  0x%02x %c", cycles_to_master_us(t->start) / 1000.0, t->address, t->read ? 'r' : 'w');
+    for (uint8_t i = 0; i < t->length; ++i) {
+        printf(" %02x", t->data[i]);
+    }
+    printf("%s%s\n", result ? "  " : "", result ? result : "");
+}
+
+static void i2c_done(const char *result)
+{
+    i2c_log(i2c.current, result);
+    i2c.current = NULL;
+    ++i2c_transactions;
+    i2c_busy_cycles += sim_now - i2c.began;
+}
+
+/// Fastest bus clock for each CTRLA.SPEED
+static const unsigned long i2c_speed_limits[] = {400000, 1000000, 3400000};
+
+/// Warns, once, if SERCOM0 isn't set up for the bus clock.  A real slave
+/// would misread the bus rather than say so.
+static void i2c_check_speed(void)
+{
+    static bool checked = false;
+    SercomI2cs *i2cs = &SERCOM0->I2CS;
+    uint8_t speed = i2cs->CTRLA.bit.SPEED;
+
+    if (checked) {
+        return;
+    }
+    checked = true;
+
+    if (speed >= ARRAY_SIZE(i2c_speed_limits) || bus_hz > i2c_speed_limits[speed]) {
+        fprintf(stderr, "sim: SERCOM0 has SPEED %u, too slow for a %lukHz bus\n", speed, bus_hz / 1000);
+    }
+    // The data has to be valid within 450ns of SCL falling in Fast-mode Plus
+    if (bus_hz > i2c_speed_limits[0] && i2cs->CTRLA.bit.SDAHOLD > 1) {
+        fprintf(stderr, "sim: SERCOM0's SDA hold time is too long for a %lukHz bus\n", bus_hz / 1000);
+    }
+    if (bus_hz > i2c_speed_limits[1] && !i2cs->CTRLA.bit.SCLSM) {
+        fprintf(stderr, "sim: SERCOM0 needs SCLSM for High-speed mode\n");
+    }
+}
+
+/// True if the slave is holding SCL low, having not dealt with the last byte
+static bool i2c_stretching(void)
+{
+    uint8_t busy = SERCOM0->I2CS.INTFLAG.reg & (SERCOM_I2CS_INTFLAG_DRDY | SERCOM_I2CS_INTFLAG_AMATCH);
+
+    if (!busy) {
+        i2c.held = 0;
+        return false;
+    }
+
+    if (!i2c.held) {
+        i2c.held = sim_now;
+    } else if (sim_now - i2c.held >= I2C_STRETCH_TIMEOUT_MS * CYCLES_PER_MS) {
+        i2c.held = 0;
+        i2c_done("timed out with SCL held low");
+        return true;
+    }
+
+    i2c.at = sim_now + i2c_bit_cycles;
+    return true;
+}
+
+/// If the slave NACKed the last byte written, the master stops there
+static bool i2c_write_nacked(void)
+{
+    if (!sim_i2c_nacked) {
+        return false;
+    }
+
+    sim_i2c_nacked = false;
+    snprintf(i2c.result, sizeof(i2c.result), "nack at byte %u", i2c.index - 1);
+    i2c.phase = I2C_STOP;
+    i2c.at += i2c_bit_cycles;
+    return true;
+}
+
+static void i2c_update(void)
+{
+    SercomI2cs *i2cs = &SERCOM0->I2CS;
+    uint64_t byte_cycles = 9 * (uint64_t)i2c_bit_cycles;
+
+    if (!i2c.current) {
+        if (i2c.next >= script_length || script[i2c.next].start > sim_now) {
+            return;
+        }
+        i2c.current = &script[i2c.next++];
+        i2c.phase = I2C_ADDRESS;
+        i2c.began = sim_now;
+        i2c.at = sim_now + byte_cycles;
+        return;
+    }
+
+    while (i2c.current && i2c.at == sim_now) {
+        struct transaction *t = i2c.current;
+
+        switch(i2c.phase) {
+            case I2C_ADDRESS:
+                i2c_check_speed();
+                if (!i2c_address_match(t->address)) {
+                    i2c_done("nack");
+                    break;
+                }
+                i2cs->STATUS.bit.DIR = t->read;
+                // Automatic acknowledge skips the address interrupt
+                if (!i2cs->CTRLB.bit.AACKEN) {
+                    i2c_flag(SERCOM_I2CS_INTFLAG_AMATCH);
+                }
+                i2c.phase = I2C_DATA;
+                i2c.index = 0;
+                i2c.result[0] = '\0';
+                sim_i2c_nacked = false;
+                // A read asks for its first byte straight away
+                if (!t->read) {
+                    i2c.at += byte_cycles;
+                }
+                break;
+
+            case I2C_DATA:
+                if (i2c_stretching()) {
+                    break;
+                }
+                if (t->read && i2c.index > 0) {
+                    t->data[i2c.index - 1] = i2cs->DATA.reg;
+                }
+                if (i2c_write_nacked()) {
+                    break;
+                }
+                if (i2c.index == t->length) {
+                    i2c.phase = I2C_STOP;
+                    i2c.at += i2c_bit_cycles;
+                    break;
+                }
+                if (!t->read) {
+                    i2cs->DATA.reg = t->data[i2c.index];
+                    // With SCLSM the byte is answered as it arrives, rather
+                    // than when it's read
+                    if (i2cs->CTRLA.bit.SCLSM) {
+                        sim_i2c_nacked = i2cs->CTRLB.bit.ACKACT;
+                    }
+                }
+                i2c_flag(SERCOM_I2CS_INTFLAG_DRDY);
+                // The stop follows the last byte written, once it's been taken
+                if (++i2c.index == t->length && !t->read) {
+                    i2c.phase = I2C_STOP;
+                    i2c.at += i2c_bit_cycles;
+                } else {
+                    i2c.at += byte_cycles;
+                }
+                break;
+
+            case I2C_STOP:
+                if (i2c_stretching() || i2c_write_nacked()) {
+                    break;
+                }
+                i2c_flag(SERCOM_I2CS_INTFLAG_PREC);
+                i2c_done(i2c.result[0] ? i2c.result : NULL);
+                break;
+        }
+    }
+}
+
+/// Reads the transaction script, one transaction per line:
+///
+///   <time in ms> <address> w <byte> <byte>...
+///   <time in ms> <address> r <count>
+///
+/// Numbers are C style (0x for hex), and # starts a comment.
+static void read_script(FILE *file, const char *name)
+{
+    char line[512];
+    unsigned line_number = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        struct transaction t = {0};
+        char *comment = strchr(line, '#');
+        char *token;
+        char *end;
+
+        ++line_number;
+        if (comment) {
+            *comment = '\0';
+        }
+
+        token = strtok(line, " \t\r\n");
+        if (!token) {
+            continue;
+        }
+        t.start = master_ms_to_cycles(strtod(token, &end));
+
+        token = strtok(NULL, " \t\r\n");
+        if (*end || !token) {
+            goto bad_line;
+        }
+        t.address = strtoul(token, &end, 0);
+
+        token = strtok(NULL, " \t\r\n");
+        if (*end || !token || (strcmp(token, "w") && strcmp(token, "r"))) {
+            goto bad_line;
+        }
+        t.read = !strcmp(token, "r");
+
+        while ((token = strtok(NULL, " \t\r\n"))) {
+            unsigned long value = strtoul(token, &end, 0);
+
+            if (*end) {
+                goto bad_line;
+            }
+            if (t.read) {
+                t.length = min(value, I2C_MAX_LENGTH);
+            } else if (t.length < I2C_MAX_LENGTH) {
+                t.data[t.length++] = value;
+            }
+        }
+
+        if (script_length && t.start < script[script_length - 1].start) {
+            fprintf(stderr, "%s:%u: transactions must be in time order\n", name, line_number);
+            exit(EXIT_FAILURE);
+        }
+
+        script = realloc(script, (script_length + 1) * sizeof(*script));
+        script[script_length++] = t;
+        continue;
+
+    bad_line:
+        fprintf(stderr, "%s:%u: expected <ms> <address> w <bytes...> or <ms> <address> r <count>\n", name, line_number);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// Waveform ------------------------------------------------------------------
+
+static const struct {
+    const char *name;
+    uint8_t     pin;
+} traces[] = {
+    {"segment_a", SEGMENT_A_PIN},
+    {"segment_b", SEGMENT_B_PIN},
+    {"segment_c", SEGMENT_C_PIN},
+    {"segment_d", SEGMENT_D_PIN},
+    {"segment_e", SEGMENT_E_PIN},
+    {"segment_f", SEGMENT_F_PIN},
+    {"segment_g", SEGMENT_G_PIN},
+    {"heartbeat", PIN_PA30},
+};
+
+static double trace_levels[ARRAY_SIZE(traces)];
+static uint64_t vcd_time = UINT64_MAX;
+
+/// How much of the time a pin is driven high, TCC0 outputs are averaged over
+/// a PWM period rather than traced edge by edge
+static double pin_level(uint8_t pin)
+{
+    PortGroup *group = &PORT->Group[0];
+
+    if (group->PINCFG[pin].bit.PMUXEN) {
+        uint8_t function = (pin & 1) ? group->PMUX[pin >> 1].bit.PMUXO : group->PMUX[pin >> 1].bit.PMUXE;
+
+        for (uint8_t i = 0; i < ARRAY_SIZE(tcc_outputs); ++i) {
+            if (tcc_outputs[i].pinmux == (((uint32_t)pin << 16) | function)) {
+                return tcc_output_level(tcc_outputs[i].wo);
+            }
+        }
+        return 0;
+    }
+
+    if (!(group->DIR.reg & (1UL << pin))) {
+        return 0;
+    }
+    return (group->OUT.reg >> pin) & 1;
+}
+
+static void vcd_begin(void)
+{
+    fprintf(vcd, "$timescale 1us $end\n$scope module scoreboard $end\n");
+    for (uint8_t i = 0; i < ARRAY_SIZE(traces); ++i) {
+        fprintf(vcd, "$var real 1 %c %s $end\n", '!' + i, traces[i].name);
+        trace_levels[i] = -1;
+    }
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n");
+}
+
+/// Writes out any outputs that changed since the last sample
+static void sample(void)
+{
+    if (!vcd) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(traces); ++i) {
+        double level = pin_level(traces[i].pin);
+
+        if (level == trace_levels[i]) {
+            continue;
+        }
+        if (vcd_time != sim_now) {
+            vcd_time = sim_now;
+            fprintf(vcd, "#%" PRIu64 "\n", cycles_to_master_us(sim_now));
+        }
+        fprintf(vcd, "r%.4g %c\n", level, '!' + i);
+        trace_levels[i] = level;
+    }
+}
+
+// Running -------------------------------------------------------------------
+
+void sim_handler_done(void)
+{
+    bool was_locked = sim_bus_locked();
+
+    sim_bus_unlock();
+    sample();
+    if (was_locked) {
+        sim_bus_lock();
+    }
+}
+
+void sim_wait_for_interrupt(void)
+{
+    sim_bus_unlock();
+
+    // Catch up with whatever the firmware just started or changed
+    tc_update();
+    tcc_update();
+    dmac_update();
+    sim_bus_update_irqs();
+    sample();
+
+    while (!sim_core_wake()) {
+        uint64_t next = min(min(tc_next(), tcc_next()), i2c_next());
+
+        if (next > end_time) {
+            sim_now = end_time;
+            sim_finish(EXIT_SUCCESS);
+        }
+
+        sim_now = next;
+        sim_core_update_systick();
+        tc_update();
+        tcc_update();
+        i2c_update();
+        dmac_update();
+        sim_bus_update_irqs();
+        sample();
+    }
+
+    sim_bus_lock();
+}
+
+void sim_finish(int status)
+{
+    if (report) {
+        printf("i2c: %" PRIu32 " transactions in %.3f ms of bus time at %.0fkHz\n", i2c_transactions,
+               cycles_to_master_us(i2c_busy_cycles) / 1000.0, SIM_CPU_HZ * osc_ratio / i2c_bit_cycles / 1000);
+        sim_core_report();
+    }
+
+    if (vcd) {
+        fprintf(vcd, "#%" PRIu64 "\n", cycles_to_master_us(sim_now));
+        fclose(vcd);
+    }
+    fflush(stdout);
+    exit(status);
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [-a jumpers] [-f bus_hz] [-e ppm] [-t end_ms] [-o waves.vcd] [-i] [script]\n"
+            "\n"
+            "Runs the digit firmware against I2C transactions from script (or stdin),\n"
+            "printing each transaction as it completes.\n"
+            "\n"
+            "  -a  ADDR jumpers fitted, bit 0 is ADDR1 (default 0, address 0x10)\n"
+            "  -f  I2C bus clock in Hz (default 100000), rounded to a whole number of\n"
+            "      OSC8M cycles per bit, so 3400000 runs at 4MHz\n"
+            "  -e  how fast the board's OSC8M runs against the master's clock, in ppm\n"
+            "      (default 0, negative for slow).  Times are all by the master's clock.\n"
+            "  -t  when to stop, in ms (default 1000ms after the last transaction)\n"
+            "  -o  write the segment and heartbeat outputs to a VCD file\n"
+            "  -i  print the I2C bus time, how many times each interrupt was taken, and\n"
+            "      the x86 instructions its handler ran, at the end\n",
+            name);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    double end_ms = -1;
+    int option;
+
+    while ((option = getopt(argc, argv, "a:f:e:t:o:ih")) != -1) {
+        switch(option) {
+            case 'a':
+                jumpers = strtoul(optarg, NULL, 0) & 0x7;
+                break;
+            case 'f':
+                bus_hz = max(strtoul(optarg, NULL, 0), 1UL);
+                break;
+            case 'e':
+                osc_ratio = 1 + strtod(optarg, NULL) / 1000000;
+                break;
+            case 't':
+                end_ms = strtod(optarg, NULL);
+                break;
+            case 'o':
+                vcd = fopen(optarg, "w");
+                if (!vcd) {
+                    perror(optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'i':
+                report = true;
+                sim_core_count_instructions();
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    // The master clocks the bus
+    i2c_bit_cycles = SIM_CPU_HZ * osc_ratio / bus_hz;
+
+    if (optind < argc) {
+        FILE *file = fopen(argv[optind], "r");
+
+        if (!file) {
+            perror(argv[optind]);
+            return EXIT_FAILURE;
+        }
+        read_script(file, argv[optind]);
+        fclose(file);
+    } else {
+        read_script(stdin, "stdin");
+    }
+
+    if (end_ms >= 0) {
+        end_time = master_ms_to_cycles(end_ms);
+    } else {
+        end_time = (script_length ? script[script_length - 1].start : 0) + master_ms_to_cycles(1000);
+    }
+
+    if (vcd) {
+        vcd_begin();
+    }
+
+    sim_bus_init();
+    firmware_main();
+
+    fprintf(stderr, "sim: firmware returned from main()\n");
+    sim_finish(EXIT_FAILURE);
+}
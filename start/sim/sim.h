@@ -0,0 +1,104 @@
+// Host simulator internals
+//
+#ifndef SIM_H_INCLUDED
+#define SIM_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <utils.h>
+
+/// TC1 and SERCOM0 run from OSC8M, and so does the CPU unless it's boosted.
+/// Firmware takes no time here, so the boost makes no difference.
+#define SIM_CPU_HZ 8000000UL
+
+/// Simulated time, in CPU cycles since reset
+extern uint64_t sim_now;
+
+// sim_bus.c
+
+/// Sets the registers to their reset values and starts trapping accesses
+void sim_bus_init(void);
+
+/// Lets the simulator itself get at the registers, without side effects
+void sim_bus_unlock(void);
+
+/// Goes back to trapping register accesses, for when firmware runs
+void sim_bus_lock(void);
+
+bool sim_bus_locked(void);
+
+/// Pends the interrupt of any peripheral with an enabled flag set, the
+/// interrupt lines being level sensitive
+void sim_bus_update_irqs(void);
+
+/// Starts counting the instructions run from here on, in the firmware and
+/// anything it calls, but not in the simulator's signal handlers
+void sim_bus_count_start(void);
+
+/// Stops counting, and returns how many instructions were run since
+/// sim_bus_count_start()
+uint64_t sim_bus_count_stop(void);
+
+/// Copies size bytes as the DMAC would, with the side effects of any
+/// register read or written.  The bus must be unlocked.
+void sim_bus_transfer(uintptr_t dst, uintptr_t src, size_t size);
+
+/// A DMAC channel, as seen through CHID
+struct sim_dmac_channel {
+    uint8_t        ctrla;
+    uint32_t       ctrlb;
+    uint8_t        inten;
+    uint8_t        intflag;
+    bool           fetched; // Since it was enabled, so current is in use
+    DmacDescriptor current;
+};
+
+extern struct sim_dmac_channel sim_dmac_channels[DMAC_CH_NUM];
+
+/// Stops a channel, and writes back its progress
+void sim_dmac_disable(uint8_t channel);
+
+/// Brings the channel registers up to date with the selected channel
+void sim_dmac_show_channel(void);
+
+// sim_core.c
+
+/// Pends an interrupt, as a peripheral would
+void sim_core_raise(IRQn_Type irq);
+
+/// True if an enabled interrupt is pending, so WFI would wake
+bool sim_core_wake(void);
+
+bool sim_core_in_handler(void);
+
+/// Starts counting the instructions each interrupt's handler runs, which
+/// single-steps them, so makes the simulation slower
+void sim_core_count_instructions(void);
+
+/// Prints how many times each interrupt has been taken, and the instructions
+/// its handler ran in all if they were counted
+void sim_core_report(void);
+
+/// Brings SysTick's VAL up to date with sim_now
+void sim_core_update_systick(void);
+
+// sim.c
+
+/// Value of PORT IN, given how the pins are driven and the address jumpers
+uint32_t sim_port_inputs(void);
+
+/// Runs time forward until an enabled interrupt is pending, for WFI
+void sim_wait_for_interrupt(void);
+
+/// Records whatever an interrupt handler did to the outputs
+void sim_handler_done(void);
+
+/// Set when the slave answers a byte written to it with a NACK, which ends the
+/// write early
+extern bool sim_i2c_nacked;
+
+/// Finishes the waveform and exits
+void sim_finish(int status) __attribute__((noreturn));
+
+#endif // SIM_H_INCLUDED
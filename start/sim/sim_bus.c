@@ -0,0 +1,560 @@
+// Simulated peripheral bus for the host simulator
+//
+// The peripheral registers are ordinary host memory, which is fine for plain
+// read/write registers but not for the SET/CLR/TGL style ones, write-one-to-
+// clear flags, or DATA registers where the access itself does something.  So
+// the bus is kept read-only (or inaccessible, for pages with read side
+// effects) while firmware runs.  An access faults, the page is opened up and
+// the faulting instruction single-stepped, and then the register's side
+// effects are applied from the trap handler - the firmware and ASF code run
+// unmodified.
+//
+// The same single-step trap counts the instructions interrupt handlers run,
+// for comparing how much work each takes.  Signal handlers run with the trap
+// flag clear, so the simulator's own work on a register access isn't counted.
+//
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "sim.h"
+
+#if !defined(__linux__) || !defined(__x86_64__)
+#error "The simulated bus single-steps register accesses, which needs x86-64 Linux"
+#endif
+
+#define PAGE_SIZE 4096UL
+#define PAGE_OF(address) ((uintptr_t)(address) & ~(PAGE_SIZE - 1))
+
+// EFLAGS single-step bit, and the page fault error code bit for writes
+#define EFLAGS_TF 0x100
+#define PF_WRITE 0x2
+
+uint8_t sim_apba[SIM_APB_SIZE] __attribute__((aligned(SIM_APB_SIZE)));
+uint8_t sim_apbb[SIM_APB_SIZE] __attribute__((aligned(SIM_APB_SIZE)));
+uint8_t sim_apbc[SIM_APB_SIZE] __attribute__((aligned(SIM_APB_SIZE)));
+
+static uint8_t *const arenas[] = {sim_apba, sim_apbb, sim_apbc};
+
+static Sercom *const sercoms[] = {SERCOM0, SERCOM1};
+static const IRQn_Type sercom_irqs[] = {SERCOM0_IRQn, SERCOM1_IRQn};
+static Tc *const tcs[] = {TC1, TC2};
+static const IRQn_Type tc_irqs[] = {TC1_IRQn, TC2_IRQn};
+
+/// The access being single-stepped
+static struct {
+    bool      pending; // Until the access has been single-stepped
+    uintptr_t address;
+    bool      write;
+    uint8_t   old[PAGE_SIZE]; // Page contents from before the access
+} trap;
+
+/// Set while counting instructions, each one single-stepped
+static volatile bool stepping = false;
+static volatile uint64_t steps;
+
+/// What counting nothing at all counts
+static uint64_t step_overhead;
+
+static bool locked = false;
+
+struct sim_dmac_channel sim_dmac_channels[DMAC_CH_NUM];
+
+static bool on_bus(uintptr_t address)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(arenas); ++i) {
+        if (address >= (uintptr_t)arenas[i] && address < (uintptr_t)arenas[i] + SIM_APB_SIZE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// How a page of the bus is protected while firmware runs
+static int page_protection(uintptr_t page)
+{
+    // Reading a SERCOM's DATA register does something
+    for (size_t i = 0; i < ARRAY_SIZE(sercoms); ++i) {
+        if (PAGE_OF(sercoms[i]) == page) {
+            return PROT_NONE;
+        }
+    }
+    return PROT_READ;
+}
+
+void sim_bus_lock(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(arenas); ++i) {
+        mprotect(arenas[i], SIM_APB_SIZE, PROT_READ);
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(sercoms); ++i) {
+        mprotect((void *)PAGE_OF(sercoms[i]), PAGE_SIZE, PROT_NONE);
+    }
+    locked = true;
+}
+
+void sim_bus_unlock(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(arenas); ++i) {
+        mprotect(arenas[i], SIM_APB_SIZE, PROT_READ | PROT_WRITE);
+    }
+    locked = false;
+}
+
+bool sim_bus_locked(void)
+{
+    return locked;
+}
+
+void sim_bus_update_irqs(void)
+{
+    bool was_locked = locked;
+
+    if (was_locked) {
+        sim_bus_unlock();
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(sercoms); ++i) {
+        if (sercoms[i]->I2CS.INTFLAG.reg & sercoms[i]->I2CS.INTENSET.reg) {
+            sim_core_raise(sercom_irqs[i]);
+        }
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(tcs); ++i) {
+        if (tcs[i]->COUNT16.INTFLAG.reg & tcs[i]->COUNT16.INTENSET.reg) {
+            sim_core_raise(tc_irqs[i]);
+        }
+    }
+    if (TCC0->INTFLAG.reg & TCC0->INTENSET.reg) {
+        sim_core_raise(TCC0_IRQn);
+    }
+
+    // INTPEND shows the lowest numbered channel with an interrupt pending
+    DMAC->INTPEND.reg = 0;
+    *(volatile uint32_t *)&DMAC->INTSTATUS.reg = 0;
+    for (uint8_t i = DMAC_CH_NUM; i-- > 0;) {
+        uint8_t pending = sim_dmac_channels[i].intflag & sim_dmac_channels[i].inten;
+
+        if (pending) {
+            DMAC->INTPEND.reg = DMAC_INTPEND_ID(i) | (pending << DMAC_INTPEND_TERR_Pos);
+            *(volatile uint32_t *)&DMAC->INTSTATUS.reg |= 1UL << i;
+            sim_core_raise(DMAC_IRQn);
+        }
+    }
+
+    if (was_locked) {
+        sim_bus_lock();
+    }
+}
+
+// Register helpers, width is in bytes
+
+static bool touches(uintptr_t address, volatile const void *reg, size_t width)
+{
+    return address >= (uintptr_t)reg && address < (uintptr_t)reg + width;
+}
+
+static uint32_t get(volatile const void *reg, size_t width)
+{
+    switch(width) {
+        case 1: return *(volatile const uint8_t *)reg;
+        case 2: return *(volatile const uint16_t *)reg;
+        default: return *(volatile const uint32_t *)reg;
+    }
+}
+
+static void put(volatile void *reg, size_t width, uint32_t value)
+{
+    switch(width) {
+        case 1: *(volatile uint8_t *)reg = value; break;
+        case 2: *(volatile uint16_t *)reg = value; break;
+        default: *(volatile uint32_t *)reg = value; break;
+    }
+}
+
+/// Value of a register from before the access being handled
+static uint32_t old(volatile const void *reg, size_t width)
+{
+    const uint8_t *copy = &trap.old[(uintptr_t)reg - PAGE_OF(trap.address)];
+    uint32_t value = 0;
+
+    memcpy(&value, copy, width);
+    return value;
+}
+
+/// Handles a write to either half of an xxxCLR/xxxSET register pair
+static bool set_clear(uintptr_t address, volatile void *clr, volatile void *set, size_t width)
+{
+    uint32_t value;
+
+    if (touches(address, set, width)) {
+        value = old(set, width) | get(set, width);
+    } else if (touches(address, clr, width)) {
+        value = old(set, width) & ~get(clr, width);
+    } else {
+        return false;
+    }
+
+    // Both halves read back as the current value
+    put(set, width, value);
+    put(clr, width, value);
+    return true;
+}
+
+/// Handles a write to a write-one-to-clear register
+static bool one_to_clear(uintptr_t address, volatile void *reg, size_t width)
+{
+    if (!touches(address, reg, width)) {
+        return false;
+    }
+
+    put(reg, width, old(reg, width) & ~get(reg, width));
+    return true;
+}
+
+static void port_written(uintptr_t address)
+{
+    PortGroup *group = &PORT->Group[0];
+
+    if (touches(address, &group->DIRCLR, 4)) {
+        group->DIR.reg &= ~group->DIRCLR.reg;
+    } else if (touches(address, &group->DIRSET, 4)) {
+        group->DIR.reg |= group->DIRSET.reg;
+    } else if (touches(address, &group->DIRTGL, 4)) {
+        group->DIR.reg ^= group->DIRTGL.reg;
+    } else if (touches(address, &group->OUTCLR, 4)) {
+        group->OUT.reg &= ~group->OUTCLR.reg;
+    } else if (touches(address, &group->OUTSET, 4)) {
+        group->OUT.reg |= group->OUTSET.reg;
+    } else if (touches(address, &group->OUTTGL, 4)) {
+        group->OUT.reg ^= group->OUTTGL.reg;
+    } else if (touches(address, &group->WRCONFIG, 4)) {
+        uint32_t config = group->WRCONFIG.reg;
+        uint32_t pins = (config & PORT_WRCONFIG_PINMASK_Msk) << ((config & PORT_WRCONFIG_HWSEL) ? 16 : 0);
+
+        for (uint8_t pin = 0; pin < 32; ++pin) {
+            if (!(pins & (1UL << pin))) {
+                continue;
+            }
+            if (config & PORT_WRCONFIG_WRPINCFG) {
+                group->PINCFG[pin].reg = (config >> PORT_WRCONFIG_PMUXEN_Pos) &
+                                         (PORT_PINCFG_PMUXEN | PORT_PINCFG_INEN |
+                                          PORT_PINCFG_PULLEN | PORT_PINCFG_DRVSTR);
+            }
+            if (config & PORT_WRCONFIG_WRPMUX) {
+                uint8_t pmux = (config & PORT_WRCONFIG_PMUX_Msk) >> PORT_WRCONFIG_PMUX_Pos;
+
+                if (pin & 1) {
+                    group->PMUX[pin >> 1].bit.PMUXO = pmux;
+                } else {
+                    group->PMUX[pin >> 1].bit.PMUXE = pmux;
+                }
+            }
+        }
+        group->WRCONFIG.reg = 0;
+    }
+
+    // The action registers all read back as the value they act on
+    group->DIRCLR.reg = group->DIRSET.reg = group->DIRTGL.reg = group->DIR.reg;
+    group->OUTCLR.reg = group->OUTSET.reg = group->OUTTGL.reg = group->OUT.reg;
+    *(volatile uint32_t *)&group->IN.reg = sim_port_inputs();
+}
+
+static void sercom_accessed(Sercom *sercom, uintptr_t address, bool write)
+{
+    SercomI2cs *i2cs = &sercom->I2CS;
+    bool slave = i2cs->CTRLA.bit.MODE == 0x4;
+    bool smart = i2cs->CTRLB.bit.SMEN;
+
+    // With SCLSM, sim.c answers each byte as it arrives instead
+    bool answer = !i2cs->CTRLA.bit.SCLSM;
+
+    if (!write) {
+        // Smart mode acknowledges a received byte when it's read
+        if (slave && smart && touches(address, &i2cs->DATA, 1) && !i2cs->STATUS.bit.DIR &&
+            (i2cs->INTFLAG.reg & SERCOM_I2CS_INTFLAG_DRDY)) {
+            i2cs->INTFLAG.reg &= ~SERCOM_I2CS_INTFLAG_DRDY;
+            if (answer) {
+                sim_i2c_nacked = i2cs->CTRLB.bit.ACKACT;
+            }
+        }
+        return;
+    }
+
+    if (touches(address, &i2cs->CTRLA, 4) && (i2cs->CTRLA.reg & SERCOM_I2CS_CTRLA_SWRST)) {
+        memset(sercom, 0, sizeof(*sercom));
+    } else if (set_clear(address, &i2cs->INTENCLR, &i2cs->INTENSET, 1) ||
+               one_to_clear(address, &i2cs->INTFLAG, 1) ||
+               one_to_clear(address, &i2cs->STATUS, 2)) {
+        // Nothing more to do
+    } else if (slave && touches(address, &i2cs->CTRLB, 4) && i2cs->CTRLB.bit.CMD) {
+        // Every command finishes with the current byte or address
+        if (answer && (i2cs->INTFLAG.reg & SERCOM_I2CS_INTFLAG_DRDY) && !i2cs->STATUS.bit.DIR) {
+            sim_i2c_nacked = i2cs->CTRLB.bit.ACKACT;
+        }
+        i2cs->INTFLAG.reg &= ~(SERCOM_I2CS_INTFLAG_DRDY | SERCOM_I2CS_INTFLAG_AMATCH);
+        i2cs->CTRLB.bit.CMD = 0;
+    } else if (slave && smart && touches(address, &i2cs->DATA, 1) && i2cs->STATUS.bit.DIR) {
+        // Writing the byte to send releases the clock
+        i2cs->INTFLAG.reg &= ~SERCOM_I2CS_INTFLAG_DRDY;
+    }
+}
+
+static void tc_written(Tc *tc, uintptr_t address)
+{
+    TcCount16 *count16 = &tc->COUNT16;
+
+    if (touches(address, &count16->CTRLA, 2) && (count16->CTRLA.reg & TC_CTRLA_SWRST)) {
+        memset(tc, 0, sizeof(*tc));
+    } else if (!set_clear(address, &count16->INTENCLR, &count16->INTENSET, 1) &&
+               !set_clear(address, &count16->CTRLBCLR, &count16->CTRLBSET, 1)) {
+        one_to_clear(address, &count16->INTFLAG, 1);
+    }
+}
+
+static void tcc_written(Tcc *tcc, uintptr_t address)
+{
+    if (touches(address, &tcc->CTRLA, 4) && (tcc->CTRLA.reg & TCC_CTRLA_SWRST)) {
+        memset(tcc, 0, sizeof(*tcc));
+        return;
+    }
+
+    if (set_clear(address, &tcc->INTENCLR, &tcc->INTENSET, 4) ||
+        set_clear(address, &tcc->CTRLBCLR, &tcc->CTRLBSET, 1) ||
+        one_to_clear(address, &tcc->INTFLAG, 4)) {
+        return;
+    }
+
+    // Writing a buffer register marks it valid, for the next UPDATE
+    for (uint8_t i = 0; i < ARRAY_SIZE(tcc->CCB); ++i) {
+        if (touches(address, &tcc->CCB[i], 4)) {
+            tcc->STATUS.reg |= TCC_STATUS_CCBV0 << i;
+        }
+    }
+    if (touches(address, &tcc->PERB, 4)) {
+        tcc->STATUS.reg |= TCC_STATUS_PERBV;
+    } else if (touches(address, &tcc->PATTB, 2)) {
+        tcc->STATUS.reg |= TCC_STATUS_PATTBV;
+    }
+}
+
+void sim_dmac_show_channel(void)
+{
+    Dmac *dmac = DMAC;
+    struct sim_dmac_channel *channel = &sim_dmac_channels[dmac->CHID.bit.ID % DMAC_CH_NUM];
+
+    dmac->CHCTRLA.reg = channel->ctrla;
+    dmac->CHCTRLB.reg = channel->ctrlb;
+    dmac->CHINTENSET.reg = dmac->CHINTENCLR.reg = channel->inten;
+    dmac->CHINTFLAG.reg = channel->intflag;
+}
+
+void sim_dmac_disable(uint8_t i)
+{
+    struct sim_dmac_channel *channel = &sim_dmac_channels[i];
+
+    // The write-back only changes once the descriptor has been fetched
+    if ((channel->ctrla & DMAC_CHCTRLA_ENABLE) && channel->fetched) {
+        ((DmacDescriptor *)(uintptr_t)DMAC->WRBADDR.reg)[i] = channel->current;
+    }
+    channel->ctrla &= ~DMAC_CHCTRLA_ENABLE;
+}
+
+static void dmac_written(uintptr_t address)
+{
+    Dmac *dmac = DMAC;
+    uint8_t i = dmac->CHID.bit.ID % DMAC_CH_NUM;
+    struct sim_dmac_channel *channel = &sim_dmac_channels[i];
+
+    if (touches(address, &dmac->CTRL, 2) && (dmac->CTRL.reg & DMAC_CTRL_SWRST)) {
+        memset(dmac, 0, sizeof(*dmac));
+        memset(sim_dmac_channels, 0, sizeof(sim_dmac_channels));
+    } else if (touches(address, &dmac->CHCTRLA, 1)) {
+        uint8_t ctrla = dmac->CHCTRLA.reg;
+
+        if (ctrla & DMAC_CHCTRLA_SWRST) {
+            memset(channel, 0, sizeof(*channel));
+        } else if (!(ctrla & DMAC_CHCTRLA_ENABLE)) {
+            sim_dmac_disable(i);
+        } else if (!(channel->ctrla & DMAC_CHCTRLA_ENABLE)) {
+            channel->ctrla = ctrla;
+            channel->fetched = false;
+        }
+    } else if (touches(address, &dmac->CHCTRLB, 4)) {
+        channel->ctrlb = dmac->CHCTRLB.reg;
+    } else if (set_clear(address, &dmac->CHINTENCLR, &dmac->CHINTENSET, 1)) {
+        channel->inten = dmac->CHINTENSET.reg;
+    } else if (one_to_clear(address, &dmac->CHINTFLAG, 1)) {
+        channel->intflag = dmac->CHINTFLAG.reg;
+    }
+
+    sim_dmac_show_channel();
+}
+
+/// Applies the side effects of the access that was just single-stepped
+static void bus_accessed(uintptr_t address, bool write)
+{
+    if (touches(address, PORT, sizeof(Port))) {
+        if (write) {
+            port_written(address);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(sercoms); ++i) {
+        if (touches(address, sercoms[i], sizeof(Sercom))) {
+            sercom_accessed(sercoms[i], address, write);
+            return;
+        }
+    }
+
+    if (!write) {
+        return;
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(tcs); ++i) {
+        if (touches(address, tcs[i], sizeof(Tc))) {
+            tc_written(tcs[i], address);
+            return;
+        }
+    }
+
+    if (touches(address, TCC0, sizeof(Tcc))) {
+        tcc_written(TCC0, address);
+    } else if (touches(address, DMAC, sizeof(Dmac))) {
+        dmac_written(address);
+    }
+}
+
+static bool has_irq(uintptr_t address)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(sercoms); ++i) {
+        if (touches(address, sercoms[i], sizeof(Sercom))) {
+            return true;
+        }
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(tcs); ++i) {
+        if (touches(address, tcs[i], sizeof(Tc))) {
+            return true;
+        }
+    }
+    return touches(address, TCC0, sizeof(Tcc)) || touches(address, DMAC, sizeof(Dmac));
+}
+
+void sim_bus_transfer(uintptr_t dst, uintptr_t src, size_t size)
+{
+    bool dst_on_bus = on_bus(dst);
+
+    // The write side effects compare against what was there before
+    if (dst_on_bus) {
+        trap.address = dst;
+        memcpy(trap.old, (void *)PAGE_OF(dst), PAGE_SIZE);
+    }
+
+    memcpy((void *)dst, (const void *)src, size);
+
+    if (on_bus(src)) {
+        bus_accessed(src, false);
+    }
+    if (dst_on_bus) {
+        bus_accessed(dst, true);
+    }
+}
+
+static void segv_handler(int signal, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = context;
+    uintptr_t address = (uintptr_t)info->si_addr;
+
+    if (!on_bus(address)) {
+        // A real crash, let it happen
+        struct sigaction action = {.sa_handler = SIG_DFL};
+        sigaction(SIGSEGV, &action, NULL);
+        return;
+    }
+
+    trap.pending = true;
+    trap.address = address;
+    trap.write = uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE;
+    mprotect((void *)PAGE_OF(address), PAGE_SIZE, PROT_READ | PROT_WRITE);
+    memcpy(trap.old, (void *)PAGE_OF(address), PAGE_SIZE);
+
+    uc->uc_mcontext.gregs[REG_EFL] |= EFLAGS_TF;
+}
+
+static void trap_handler(int signal, siginfo_t *info, void *context)
+{
+    ucontext_t *uc = context;
+    uintptr_t page = PAGE_OF(trap.address);
+
+    if (stepping) {
+        ++steps;
+    } else {
+        uc->uc_mcontext.gregs[REG_EFL] &= ~EFLAGS_TF;
+    }
+
+    if (!trap.pending) {
+        return;
+    }
+    trap.pending = false;
+
+    // A read-modify-write may have been reported as a read
+    if (memcmp(trap.old, (void *)page, PAGE_SIZE)) {
+        trap.write = true;
+    }
+
+    bus_accessed(trap.address, trap.write);
+    mprotect((void *)page, PAGE_SIZE, page_protection(page));
+
+    // Enabling an interrupt with its flag already set raises it.  Handlers
+    // are left alone, sim_core.c looks again once they return.
+    if (trap.write && has_irq(trap.address) && !sim_core_in_handler()) {
+        sim_bus_update_irqs();
+    }
+}
+
+// pushfq writes below the stack pointer, so step over the red zone first
+#define SET_TRAP_FLAG() __asm__ volatile("sub $128, %%rsp\n\tpushfq\n\torq %0, (%%rsp)\n\tpopfq\n\tadd $128, %%rsp" \
+                                         :                                                                    \
+                                         : "i"(EFLAGS_TF)                                                     \
+                                         : "memory", "cc")
+#define CLEAR_TRAP_FLAG() __asm__ volatile("sub $128, %%rsp\n\tpushfq\n\tandq %0, (%%rsp)\n\tpopfq\n\tadd $128, %%rsp" \
+                                           :                                                                     \
+                                           : "i"(~EFLAGS_TF)                                                     \
+                                           : "memory", "cc")
+
+void sim_bus_count_start(void)
+{
+    steps = 0;
+    stepping = true;
+    SET_TRAP_FLAG();
+}
+
+uint64_t sim_bus_count_stop(void)
+{
+    CLEAR_TRAP_FLAG();
+    stepping = false;
+    return steps - step_overhead;
+}
+
+void sim_bus_init(void)
+{
+    struct sigaction action = {.sa_flags = SA_SIGINFO};
+
+    sigemptyset(&action.sa_mask);
+    action.sa_sigaction = segv_handler;
+    sigaction(SIGSEGV, &action, NULL);
+    action.sa_sigaction = trap_handler;
+    sigaction(SIGTRAP, &action, NULL);
+
+    // Oscillators and the like are ready as soon as they're asked
+    *(volatile uint32_t *)&SYSCTRL->PCLKSR.reg = SYSCTRL_PCLKSR_MASK;
+    NVMCTRL->INTFLAG.reg = NVMCTRL_INTFLAG_READY;
+
+    sim_bus_count_start();
+    step_overhead = sim_bus_count_stop();
+
+    sim_bus_lock();
+}
@@ -0,0 +1,223 @@
+// Simulated Cortex-M0+ core: interrupts, SysTick and WFI
+//
+// Firmware code takes no simulated time, time only moves on in WFI.  So
+// interrupts are only ever raised from inside WFI, and are taken as soon as
+// PRIMASK allows - straight away, or when the critical section around the
+// WFI ends.
+//
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+void DMAC_Handler(void);
+void SERCOM0_Handler(void);
+void TC1_Handler(void);
+void TCC0_Handler(void);
+
+SysTick_Type sim_systick;
+SCB_Type     sim_scb;
+
+static const struct {
+    const char *name;
+    void (*handler)(void);
+} handlers[PERIPH_COUNT_IRQn] = {
+    [DMAC_IRQn]    = {"DMAC", DMAC_Handler},
+    [SERCOM0_IRQn] = {"SERCOM0", SERCOM0_Handler},
+    [TC1_IRQn]     = {"TC1", TC1_Handler},
+    [TCC0_IRQn]    = {"TCC0", TCC0_Handler},
+};
+
+/// Times each interrupt has been taken
+static uint32_t counts[PERIPH_COUNT_IRQn];
+
+/// Host instructions each interrupt's handler has run, all told
+static bool counting = false;
+static uint64_t instructions[PERIPH_COUNT_IRQn];
+
+static uint32_t primask = 0;
+static uint32_t enabled = 0;
+static uint32_t pending = 0;
+static bool in_handler = false;
+
+/// Handlers taken since the last WFI, to catch one that never clears its flag
+static uint32_t taken = 0;
+
+#define INTERRUPT_STORM 100000
+
+static bool systick_running = false;
+static uint64_t systick_start;
+
+/// Takes pending interrupts, lowest number first as they're all one priority
+static void take_interrupts(void)
+{
+    if (in_handler) {
+        return;
+    }
+
+    while (!primask && (pending & enabled)) {
+        uint8_t irq = __builtin_ctz(pending & enabled);
+
+        pending &= ~(1UL << irq);
+        if (++taken > INTERRUPT_STORM) {
+            fprintf(stderr, "sim: IRQ %u keeps firing without time moving on\n", irq);
+            sim_finish(EXIT_FAILURE);
+        }
+        if (!handlers[irq].handler) {
+            fprintf(stderr, "sim: IRQ %u has no handler\n", irq);
+            sim_finish(EXIT_FAILURE);
+        }
+
+        in_handler = true;
+        sim_scb.ICSR = irq + 16;
+        ++counts[irq];
+        if (counting) {
+            sim_bus_count_start();
+            handlers[irq].handler();
+            instructions[irq] += sim_bus_count_stop();
+        } else {
+            handlers[irq].handler();
+        }
+        sim_scb.ICSR = 0;
+        in_handler = false;
+
+        sim_bus_update_irqs();
+        sim_handler_done();
+    }
+}
+
+void sim_core_raise(IRQn_Type irq)
+{
+    pending |= 1UL << irq;
+}
+
+void sim_core_count_instructions(void)
+{
+    counting = true;
+}
+
+bool sim_core_in_handler(void)
+{
+    return in_handler;
+}
+
+void sim_core_report(void)
+{
+    printf("interrupts:");
+    for (uint8_t irq = 0; irq < PERIPH_COUNT_IRQn; ++irq) {
+        if (handlers[irq].handler) {
+            printf(" %s %" PRIu32, handlers[irq].name, counts[irq]);
+        }
+    }
+    printf("\n");
+
+    if (!counting) {
+        return;
+    }
+    printf("x86 instructions:");
+    for (uint8_t irq = 0; irq < PERIPH_COUNT_IRQn; ++irq) {
+        if (handlers[irq].handler) {
+            printf(" %s %" PRIu64, handlers[irq].name, instructions[irq]);
+        }
+    }
+    printf("\n");
+}
+
+bool sim_core_wake(void)
+{
+    return pending & enabled;
+}
+
+void sim_core_update_systick(void)
+{
+    if (!(sim_systick.CTRL & SysTick_CTRL_ENABLE_Msk)) {
+        systick_running = false;
+        return;
+    }
+
+    if (!systick_running) {
+        systick_running = true;
+        systick_start = sim_now;
+    }
+
+    uint32_t reload = sim_systick.LOAD & SysTick_LOAD_RELOAD_Msk;
+    sim_systick.VAL = reload - (sim_now - systick_start) % ((uint64_t)reload + 1);
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    enabled |= 1UL << irq;
+    take_interrupts();
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    enabled &= ~(1UL << irq);
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type irq)
+{
+    sim_core_raise(irq);
+    take_interrupts();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    pending &= ~(1UL << irq);
+}
+
+void NVIC_SetPriority(IRQn_Type irq, uint32_t priority)
+{
+    (void)irq;
+    (void)priority;
+}
+
+void NVIC_SystemReset(void)
+{
+    fprintf(stderr, "sim: firmware asked for a reset\n");
+    sim_finish(EXIT_FAILURE);
+}
+
+uint32_t __get_IPSR(void)
+{
+    return sim_scb.ICSR & SCB_ICSR_VECTACTIVE_Msk;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return primask;
+}
+
+void __set_PRIMASK(uint32_t mask)
+{
+    primask = mask & 1;
+    take_interrupts();
+}
+
+void __disable_irq(void)
+{
+    primask = 1;
+}
+
+void __enable_irq(void)
+{
+    primask = 0;
+    take_interrupts();
+}
+
+void __WFI(void)
+{
+    taken = 0;
+    sim_wait_for_interrupt();
+    take_interrupts();
+}
+
+/// Replaces the BKPT in utils_assert.c
+void assert(const bool condition, const char *const file, const int line)
+{
+    if (!condition) {
+        fprintf(stderr, "sim: assertion failed at %s:%d\n", file, line);
+        sim_finish(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,82 @@
+// Device header for the host simulator, force-included ahead of everything
+//
+// Pulls in the real SAMD10 device header, then moves every peripheral onto
+// the simulated bus in sim_bus.c.  Each APB bridge gets its own block of
+// host memory, with peripherals at their real offsets within it, so the HPL's
+// "(hw - SERCOM0) >> 10" style instance arithmetic still works.
+//
+#ifndef SIM_DEVICE_H_INCLUDED
+#define SIM_DEVICE_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <sam.h>
+
+#define SIM_APB_SIZE 0x10000
+
+extern uint8_t sim_apba[SIM_APB_SIZE];
+extern uint8_t sim_apbb[SIM_APB_SIZE];
+extern uint8_t sim_apbc[SIM_APB_SIZE];
+
+#define SIM_APBA(type, address) ((type *)&sim_apba[(address) & (SIM_APB_SIZE - 1)])
+#define SIM_APBB(type, address) ((type *)&sim_apbb[(address) & (SIM_APB_SIZE - 1)])
+#define SIM_APBC(type, address) ((type *)&sim_apbc[(address) & (SIM_APB_SIZE - 1)])
+
+#undef ADC
+#undef DAC
+#undef DMAC
+#undef DSU
+#undef EIC
+#undef EVSYS
+#undef GCLK
+#undef SBMATRIX
+#undef MTB
+#undef NVMCTRL
+#undef PAC0
+#undef PAC1
+#undef PAC2
+#undef PM
+#undef PORT
+#undef PORT_IOBUS
+#undef PTC
+#undef RTC
+#undef SERCOM0
+#undef SERCOM1
+#undef SYSCTRL
+#undef TC1
+#undef TC2
+#undef TCC0
+#undef WDT
+
+#define PAC0     SIM_APBA(Pac,      0x40000000UL)
+#define PM       SIM_APBA(Pm,       0x40000400UL)
+#define SYSCTRL  SIM_APBA(Sysctrl,  0x40000800UL)
+#define GCLK     SIM_APBA(Gclk,     0x40000C00UL)
+#define WDT      SIM_APBA(Wdt,      0x40001000UL)
+#define RTC      SIM_APBA(Rtc,      0x40001400UL)
+#define EIC      SIM_APBA(Eic,      0x40001800UL)
+
+#define PAC1     SIM_APBB(Pac,      0x41000000UL)
+#define DSU      SIM_APBB(Dsu,      0x41002000UL)
+#define NVMCTRL  SIM_APBB(Nvmctrl,  0x41004000UL)
+#define PORT     SIM_APBB(Port,     0x41004400UL)
+#define DMAC     SIM_APBB(Dmac,     0x41004800UL)
+#define MTB      SIM_APBB(Mtb,      0x41006000UL)
+#define SBMATRIX SIM_APBB(Hmatrixb, 0x41007000UL)
+
+// The IOBUS is another view of the same PORT registers
+#define PORT_IOBUS PORT
+
+#define PAC2     SIM_APBC(Pac,      0x42000000UL)
+#define EVSYS    SIM_APBC(Evsys,    0x42000400UL)
+#define SERCOM0  SIM_APBC(Sercom,   0x42000800UL)
+#define SERCOM1  SIM_APBC(Sercom,   0x42000C00UL)
+#define TCC0     SIM_APBC(Tcc,      0x42001400UL)
+#define TC1      SIM_APBC(Tc,       0x42001800UL)
+#define TC2      SIM_APBC(Tc,       0x42001C00UL)
+#define ADC      SIM_APBC(Adc,      0x42002000UL)
+#define DAC      SIM_APBC(Dac,      0x42002800UL)
+#define PTC      SIM_APBC(void,     0x42002C00UL)
+
+#endif // SIM_DEVICE_H_INCLUDED
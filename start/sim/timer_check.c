@@ -0,0 +1,208 @@
+// Checks of the HAL timer's task scheduling, for make check
+//
+// hal_timer.c is built on its own here, against a stand-in for the TC that
+// counts nothing, so each period_expired() call runs the ticks up to the next
+// task due.  The callbacks add and remove other tasks due in the same tick,
+// which the wheel has to let them do just as the list did.
+//
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <hal_atomic.h>
+#include <hal_timer.h>
+
+/// A whole turn of the wheel's first level, or as long for the list
+#if TIMER_WHEEL_ENABLED
+#define TURN TIMER_WHEEL_SLOTS
+#else
+#define TURN 16
+#endif
+
+static struct timer_descriptor timer;
+
+/// ASSERT()s that fail, which would be a BKPT on a board
+static int assertions = 0;
+
+void assert(const bool condition, const char *const file, const int line)
+{
+    if (!condition) {
+        printf("ASSERT at %s:%d\n", file, line);
+        ++assertions;
+    }
+}
+
+void atomic_enter_critical(hal_atomic_t volatile *atomic)
+{
+}
+
+void atomic_leave_critical(hal_atomic_t volatile *atomic)
+{
+}
+
+// The TC stand-in, with a 16 bit counter stuck at 0
+static uint32_t period = 999;
+
+int32_t _timer_init(struct _timer_device *const device, void *const hw)
+{
+    return ERR_NONE;
+}
+
+void _timer_deinit(struct _timer_device *const device)
+{
+}
+
+void _timer_start(struct _timer_device *const device)
+{
+}
+
+void _timer_stop(struct _timer_device *const device)
+{
+}
+
+void _timer_set_period(struct _timer_device *const device, const uint32_t clock_cycles)
+{
+    period = clock_cycles;
+}
+
+uint32_t _timer_get_period(const struct _timer_device *const device)
+{
+    return period;
+}
+
+uint32_t _timer_get_max_period(const struct _timer_device *const device)
+{
+    return UINT16_MAX;
+}
+
+uint32_t _timer_get_counter(const struct _timer_device *const device)
+{
+    return 0;
+}
+
+bool _timer_is_period_expired(const struct _timer_device *const device)
+{
+    return false;
+}
+
+bool _timer_is_started(const struct _timer_device *const device)
+{
+    return true;
+}
+
+void _timer_set_irq(struct _timer_device *const device)
+{
+}
+
+/// A task, with the siblings due in the same tick that its callback changes
+struct check_task {
+    struct timer_task task; // First, so a timer_task is a check_task
+    const char *name;
+    uint32_t runs;
+    uint32_t last_run;
+    bool pending;
+    struct check_task *siblings[2];
+    uint32_t readd_interval; // Siblings are re-added with this interval, or 0 not to
+};
+
+static void check_task_cb(const struct timer_task *const timer_task)
+{
+    struct check_task *check = (struct check_task *)timer_task;
+
+    ++check->runs;
+    check->last_run = timer_get_ticks(&timer);
+    check->pending = check->task.mode == TIMER_TASK_REPEAT;
+
+    for (int i = 0; i < 2; ++i) {
+        struct check_task *sibling = check->siblings[i];
+
+        if (!sibling || !sibling->pending) {
+            continue;
+        }
+        timer_remove_task(&timer, &sibling->task);
+        sibling->pending = false;
+
+        if (check->readd_interval) {
+            sibling->task.interval = check->readd_interval;
+            timer_add_task(&timer, &sibling->task);
+            sibling->pending = true;
+        }
+    }
+}
+
+static void check_task_add(struct check_task *check, const char *name, uint32_t interval, enum timer_task_mode mode)
+{
+    check->name = name;
+    check->task.interval = interval;
+    check->task.cb = check_task_cb;
+    check->task.mode = mode;
+    check->pending = true;
+    timer_add_task(&timer, &check->task);
+}
+
+static int failures = 0;
+
+static void expect(const struct check_task *check, uint32_t runs, uint32_t last_run)
+{
+    if (check->runs != runs || (runs && check->last_run != last_run)) {
+        printf("task %s ran %u times, last at %u, not %u times, last at %u\n", check->name, (unsigned)check->runs,
+               (unsigned)check->last_run, (unsigned)runs, (unsigned)last_run);
+        ++failures;
+    }
+}
+
+int main(void)
+{
+    // a, b and c are all due at 5, and whichever runs first cancels the others
+    static struct check_task a, b, c;
+
+    // d and e are due at 20, and whichever runs first moves the other to 23
+    static struct check_task d, e;
+
+    // f repeats every turn of the wheel's first level, so is put back in the
+    // slot it runs from
+    static struct check_task f;
+
+    timer_init(&timer, &period, NULL);
+
+    check_task_add(&a, "a", 5, TIMER_TASK_ONE_SHOT);
+    check_task_add(&b, "b", 5, TIMER_TASK_ONE_SHOT);
+    check_task_add(&c, "c", 5, TIMER_TASK_ONE_SHOT);
+    a.siblings[0] = &b, a.siblings[1] = &c;
+    b.siblings[0] = &a, b.siblings[1] = &c;
+    c.siblings[0] = &a, c.siblings[1] = &b;
+
+    check_task_add(&d, "d", 20, TIMER_TASK_ONE_SHOT);
+    check_task_add(&e, "e", 20, TIMER_TASK_ONE_SHOT);
+    d.siblings[0] = &e, d.readd_interval = 3;
+    e.siblings[0] = &d, e.readd_interval = 3;
+
+    check_task_add(&f, "f", TURN, TIMER_TASK_REPEAT);
+
+    // Up to f's third run, which is after all the others
+    timer_start(&timer);
+    for (int i = 0; i < 100 && timer_get_ticks(&timer) < 3 * TURN; ++i) {
+        timer.device.timer_cb.period_expired(&timer.device);
+    }
+
+    if (a.runs + b.runs + c.runs != 1) {
+        printf("a, b and c ran %u times between them, not once\n", (unsigned)(a.runs + b.runs + c.runs));
+        ++failures;
+    }
+    expect(a.runs ? &a : b.runs ? &b : &c, 1, 5);
+
+    if (d.runs + e.runs != 2) {
+        printf("d and e ran %u times between them, not twice\n", (unsigned)(d.runs + e.runs));
+        ++failures;
+    }
+    expect(d.last_run == 20 ? &d : &e, 1, 20);
+    expect(d.last_run == 20 ? &e : &d, 1, 23);
+
+    expect(&f, 3, 3 * TURN);
+
+    if (failures || assertions) {
+        printf("FAILED\n");
+        return EXIT_FAILURE;
+    }
+    printf("ok\n");
+    return EXIT_SUCCESS;
+}
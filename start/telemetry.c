@@ -0,0 +1,47 @@
+// Health and state of a board, for the master to read back
+//
+#include "telemetry.h"
+
+#include "bench.h"
+#include "display.h"
+
+static struct telemetry buffers[2];
+
+static uint8_t board_address = 0;
+
+void telemetry_set_address(uint8_t address)
+{
+    board_address = address;
+}
+
+const struct telemetry *telemetry_update(const struct telemetry_iic_counts *iic, const void *in_use)
+{
+    struct telemetry *t = &buffers[in_use == &buffers[0]];
+
+    t->version = TELEMETRY_VERSION;
+    t->length = sizeof(*t);
+    t->firmware_version = FIRMWARE_VERSION;
+
+    t->address = board_address;
+    t->segments = display_get_segments();
+    t->reset_cause = hri_pm_read_RCAUSE_reg(PM);
+    t->register_count = REG_COUNT;
+
+    // TIMER_0 ticks every millisecond
+    t->uptime_seconds = timer_get_ticks(&TIMER_0) / 1000;
+
+    t->rx_bytes = iic->rx_bytes;
+    t->rx_frames = iic->rx_frames;
+    t->rx_nacks = iic->rx_nacks;
+    t->rx_holds = iic->rx_holds;
+    t->rx_frames_dropped = iic->rx_frames_dropped;
+    t->bus_errors = iic->bus_errors;
+
+    t->sercom0_handler_cycles_max = bench_stats.probes[BENCH_SERCOM0_HANDLER].max;
+    t->tc1_handler_cycles_max = bench_stats.probes[BENCH_TC1_HANDLER].max;
+    t->stop_to_display_max = bench_stats.probes[BENCH_STOP_TO_DISPLAY].max;
+
+    protocol_get_registers(t->registers);
+
+    return t;
+}
@@ -0,0 +1,82 @@
+// Health and state of a board, for the master to read back
+//
+// Any read from a board's own address gets a struct telemetry, from its first
+// byte every time, so a master can poll every board on the scoreboard in one
+// sweep of short reads.  Reading fewer bytes just stops early, and reading
+// more gets 0xFF past the end.
+//
+// Reads are answered straight from memory, with nothing to work out in the
+// I2C interrupt.  The main loop formats the telemetry ahead of time, after the
+// frames it handles and once a second, into whichever of two buffers a read
+// can't be sending from.  A read sends the telemetry as it was when the read
+// started, so it's never torn.
+//
+#ifndef TELEMETRY_H_INCLUDED
+#define TELEMETRY_H_INCLUDED
+
+#include <atmel_start.h>
+
+#include "protocol.h"
+
+/// Major version in the high byte, minor in the low
+#define FIRMWARE_VERSION 0x0100
+
+/// Bumped whenever the layout or meaning of struct telemetry changes
+#define TELEMETRY_VERSION 2
+
+/// What a master reads, little endian like the Cortex-M0+
+///
+/// Everything is naturally aligned, so there's no padding until the end.
+/// New fields go after the registers, which grow as registers are added.
+struct telemetry {
+    uint8_t version;           // TELEMETRY_VERSION
+    uint8_t length;            // sizeof(struct telemetry), for skipping what's not understood
+    uint16_t firmware_version; // FIRMWARE_VERSION
+
+    uint8_t address;        // I2C address, from the ADDR jumpers
+    uint8_t segments;       // SEGMENT_x_BITs shown, see display_get_segments()
+    uint8_t reset_cause;    // PM RCAUSE bits, from the last reset
+    uint8_t register_count; // REG_COUNT
+
+    uint32_t uptime_seconds; // Since reset, wraps after 49 days
+
+    // I2C_0 counts since reset
+    uint32_t rx_bytes;          // Bytes written to this board, including broadcasts
+    uint32_t rx_frames;         // Write transactions handed to the main loop
+    uint32_t rx_nacks;          // Writes cut short with a NACK, for want of buffer space, once each on any path
+    uint32_t rx_holds;          // Times SCL was held low, waiting for buffer space
+    uint32_t rx_frames_dropped; // Whole frames lost, for want of buffer space
+    uint32_t bus_errors;        // SERCOM0 error interrupts, eg bus errors and SCL timeouts
+
+    // Worst cases in CPU cycles, from bench_stats so since bench_reset(), or 0
+    // for the handlers if built without BENCH_ENABLED.  The handlers' are how
+    // long they ran, not how long they waited to start.
+    uint32_t sercom0_handler_cycles_max; // Longest SERCOM0_Handler run
+    uint32_t tc1_handler_cycles_max;     // Longest TC1_Handler run
+    uint32_t stop_to_display_max;        // Longest from a stop condition to the display changing
+
+    uint8_t registers[REG_COUNT]; // Register values, from REG_FIRST up
+};
+
+/// I2C_0 counts for struct telemetry, from whichever I2C_0 path is built
+struct telemetry_iic_counts {
+    uint32_t rx_bytes;
+    uint32_t rx_frames;
+    uint32_t rx_nacks;
+    uint32_t rx_holds;
+    uint32_t rx_frames_dropped;
+    uint32_t bus_errors;
+};
+
+/// Sets the address reported, before the first telemetry_update()
+void telemetry_set_address(uint8_t address);
+
+/// Formats the telemetry into the buffer that in_use isn't, and returns it for
+/// reads to be sent from
+///
+/// in_use is the buffer the current read, if any, is being sent from.  Call
+/// with interrupts masked, so that a read can't start from the other buffer
+/// while it's being written.
+const struct telemetry *telemetry_update(const struct telemetry_iic_counts *iic, const void *in_use);
+
+#endif // TELEMETRY_H_INCLUDED